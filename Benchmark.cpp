@@ -0,0 +1,316 @@
+#include "MemoryManager/MemoryManager.h"
+#include "MemoryManager/MemoryResource.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+
+// benchmarks
+void benchmarkPmrContainers();
+void benchmarkLifetimeHints();
+void benchmarkAllocateNear();
+void benchmarkBoundaryPlacement();
+
+
+// helper functions
+double runVectorWorkload(std::pmr::memory_resource *resource);
+double runUnorderedMapWorkload(std::pmr::memory_resource *resource);
+double runStringWorkload(std::pmr::memory_resource *resource);
+void printComparison(std::string name, double managerTime, double defaultTime);
+MemoryStats runMixedLifetimeWorkload(bool hinted);
+void printHoleStats(std::string name, MemoryStats stats);
+void runTraversalWorkload(bool near, double &nanosPerNode, double &averageDistance);
+double runBoundaryWorkload(size_t boundaryThreshold, MemoryStats &stats);
+
+const unsigned int repetitions = 50;
+
+int main()
+{
+    benchmarkPmrContainers();
+    benchmarkLifetimeHints();
+    benchmarkAllocateNear();
+    benchmarkBoundaryPlacement();
+}
+
+
+
+void benchmarkPmrContainers()
+{
+    std::cout << "Benchmark: std::pmr containers, MemoryManager resource vs default resource" << std::endl;
+
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 65535;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
+
+    MemoryManagerResource managerResource(memoryManager);
+    std::pmr::memory_resource *defaultResource = std::pmr::new_delete_resource();
+
+    printComparison("vector push_back", runVectorWorkload(&managerResource), runVectorWorkload(defaultResource));
+    printComparison("unordered_map insert/erase", runUnorderedMapWorkload(&managerResource), runUnorderedMapWorkload(defaultResource));
+    printComparison("string append", runStringWorkload(&managerResource), runStringWorkload(defaultResource));
+
+    memoryManager.shutdown();
+}
+
+
+void benchmarkLifetimeHints()
+{
+    std::cout << "Benchmark: mixed lifetimes, lifetime hints vs no hints (after scratch is freed)" << std::endl;
+
+    printHoleStats("No hints", runMixedLifetimeWorkload(false));
+    printHoleStats("Hints", runMixedLifetimeWorkload(true));
+}
+
+
+void benchmarkAllocateNear()
+{
+    std::cout << "Benchmark: list traversal, payloads from allocateNear(node) vs allocate" << std::endl;
+
+    double nanosPerNode = 0;
+    double averageDistance = 0;
+
+    runTraversalWorkload(false, nanosPerNode, averageDistance);
+    std::cout << "allocate" << std::endl;
+    std::cout << "Traversal:    " << nanosPerNode << " ns/node" << std::endl;
+    std::cout << "Distance:     " << averageDistance << " bytes node to payload\n" << std::endl;
+
+    runTraversalWorkload(true, nanosPerNode, averageDistance);
+    std::cout << "allocateNear" << std::endl;
+    std::cout << "Traversal:    " << nanosPerNode << " ns/node" << std::endl;
+    std::cout << "Distance:     " << averageDistance << " bytes node to payload\n" << std::endl;
+}
+
+
+void benchmarkBoundaryPlacement()
+{
+    std::cout << "Benchmark: random access to 64-byte objects between 16-byte ones, boundary-aware placement vs plain bestFit" << std::endl;
+
+    size_t thresholds[2] = { 0, 64 };
+    for (size_t i = 0; i < 2; i++)
+    {
+        MemoryStats stats;
+        double nanosPerAccess = runBoundaryWorkload(thresholds[i], stats);
+
+        std::cout << (thresholds[i] ? "Boundary-aware (64 bytes)" : "Plain") << std::endl;
+        std::cout << "Access:       " << nanosPerAccess << " ns" << std::endl;
+        std::cout << "Objects:      " << stats.allocationCount << std::endl;
+        std::cout << "Line splits:  " << stats.lineStraddlingBlocks << std::endl;
+        std::cout << "Page splits:  " << stats.pageStraddlingBlocks << std::endl;
+        std::cout << "Holes:        " << stats.holeCount << "\n" << std::endl;
+    }
+}
+
+
+double runVectorWorkload(std::pmr::memory_resource *resource)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (unsigned int r = 0; r < repetitions; ++r)
+    {
+        std::pmr::vector<uint32_t> values(resource);
+        for (uint32_t i = 0; i < 10000; ++i) { values.push_back(i); }
+    }
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+
+double runUnorderedMapWorkload(std::pmr::memory_resource *resource)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (unsigned int r = 0; r < repetitions; ++r)
+    {
+        std::pmr::unordered_map<uint32_t, uint32_t> table(resource);
+        for (uint32_t i = 0; i < 2000; ++i) { table[i] = i * 3; }
+        for (uint32_t i = 0; i < 2000; i += 2) { table.erase(i); }
+        for (uint32_t i = 0; i < 2000; i += 2) { table[i + 2000] = i; }
+    }
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+
+double runStringWorkload(std::pmr::memory_resource *resource)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (unsigned int r = 0; r < repetitions; ++r)
+    {
+        std::pmr::vector<std::pmr::string> strings(resource);
+        for (unsigned int i = 0; i < 500; ++i)
+        {
+            std::pmr::string text(resource);
+            for (unsigned int j = 0; j < 8; ++j) { text += "0123456789"; }
+            strings.push_back(std::move(text));
+        }
+    }
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+
+void printComparison(std::string name, double managerTime, double defaultTime)
+{
+    std::cout << name << std::endl;
+    std::cout << "MemoryManager: " << managerTime << " ms" << std::endl;
+    std::cout << "Default:       " << defaultTime << " ms" << std::endl;
+    std::cout << "Ratio:         " << (managerTime / defaultTime) << "x\n" << std::endl;
+}
+
+
+MemoryStats runMixedLifetimeWorkload(bool hinted)
+{
+    MemoryManager memoryManager(8, bestFit);
+    memoryManager.initialize(65535);
+
+    std::mt19937 random(42);
+    std::vector<void *> sessions;
+
+    // Each request keeps a small cache entry, holds a session for a while and uses scratch buffers
+    for (unsigned int request = 0; request < 400; ++request)
+    {
+        std::vector<void *> scratch;
+        for (unsigned int i = 0; i < 8; ++i)
+        {
+            scratch.push_back(memoryManager.allocate(64 + (random() % 512), hinted ? Lifetime::Short : Lifetime::Medium));
+            if (i == 4) { memoryManager.allocate(32 + (random() % 96), hinted ? Lifetime::Long : Lifetime::Medium); }
+        }
+
+        sessions.push_back(memoryManager.allocate(128 + (random() % 256)));
+        if (sessions.size() > 16)
+        {
+            size_t victim = random() % sessions.size();
+            memoryManager.free(sessions[victim]);
+            sessions.erase(sessions.begin() + victim);
+        }
+
+        for (auto it = scratch.begin(); it != scratch.end(); ++it) { memoryManager.free(*it); }
+    }
+
+    MemoryStats stats = memoryManager.getStats();
+    memoryManager.shutdown();
+    return stats;
+}
+
+
+void printHoleStats(std::string name, MemoryStats stats)
+{
+    std::cout << name << std::endl;
+    std::cout << "Holes:        " << stats.holeCount << std::endl;
+    std::cout << "Largest hole: " << stats.largestHole << " words" << std::endl;
+    std::cout << "Free:         " << stats.freeWords << " words\n" << std::endl;
+}
+
+
+struct ListNode
+{
+    ListNode *next;
+    uint64_t *payload;
+};
+
+void runTraversalWorkload(bool near, double &nanosPerNode, double &averageDistance)
+{
+    // 64-byte words give a 4 MiB heap, bigger than the L2 cache
+    MemoryManager memoryManager(64, bestFit);
+    memoryManager.initialize(65535);
+
+    // Scatter holes across the heap
+    std::mt19937 random(7);
+    std::vector<void *> filler;
+    while (void *block = memoryManager.allocate(64 + (random() % 2048))) { filler.push_back(block); }
+    for (size_t i = 0; i < filler.size(); i += 2) { memoryManager.free(filler[i]); }
+
+    // Build a list whose payloads are allocated right after their nodes
+    ListNode *head = nullptr;
+    size_t nodes = 0;
+    double distance = 0;
+    while (true)
+    {
+        ListNode *node = static_cast<ListNode *>(memoryManager.allocate(sizeof(ListNode)));
+        if (!node) { break; }
+
+        node->payload = static_cast<uint64_t *>(near ? memoryManager.allocateNear(node, 128) : memoryManager.allocate(128));
+        if (!node->payload)
+        {
+            memoryManager.free(node);
+            break;
+        }
+
+        node->payload[0] = nodes;
+        node->next = head;
+        head = node;
+        nodes++;
+        distance += std::abs(reinterpret_cast<char *>(node->payload) - reinterpret_cast<char *>(node));
+    }
+
+    // Walk the list, touching every payload
+    uint64_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int r = 0; r < repetitions; ++r)
+    {
+        for (ListNode *node = head; node; node = node->next) { sum += node->payload[0]; }
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+    nanosPerNode = elapsed.count() / (static_cast<double>(nodes) * repetitions);
+    averageDistance = distance / nodes;
+    if (sum == 1) { std::cout << std::endl; } // Keep the walk from being optimised away
+
+    memoryManager.shutdown();
+}
+
+
+double runBoundaryWorkload(size_t boundaryThreshold, MemoryStats &stats)
+{
+    // 16-byte words give a 1 MiB heap
+    MemoryManager memoryManager(16, bestFit);
+    memoryManager.initialize(65535);
+    memoryManager.setBoundaryThreshold(boundaryThreshold);
+
+    // Fill the heap with 64-byte objects, each followed by a 16-byte one. Packed, three in four of the 64-byte
+    // objects cross a cache line; boundary-aware placement lines them up and the 16-byte ones fill the gaps,
+    // so both fit the same number of objects
+    std::vector<uint64_t *> objects;
+    while (uint64_t *object = static_cast<uint64_t *>(memoryManager.allocate(64)))
+    {
+        for (unsigned int i = 0; i < 8; ++i) { object[i] = i; }
+        objects.push_back(object);
+        if (!memoryManager.allocate(16)) { break; }
+    }
+    stats = memoryManager.getStats();
+
+    // Link the 64-byte objects into one random cycle; the link is split between the first and last word of each object
+    std::vector<uint32_t> order(objects.size());
+    for (uint32_t i = 0; i < order.size(); ++i) { order[i] = i; }
+    std::shuffle(order.begin(), order.end(), std::mt19937(3));
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        uint64_t next = reinterpret_cast<uint64_t>(objects[order[(i + 1) % order.size()]]);
+        objects[order[i]][0] = next & 0xFFFFFFFF;
+        objects[order[i]][7] = next & ~0xFFFFFFFFULL;
+    }
+
+    // Each step needs both ends of the object before it can go on, so the time per step is the access latency
+    uint64_t *object = objects[order[0]];
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int r = 0; r < repetitions; ++r)
+    {
+        for (size_t i = 0; i < order.size(); ++i) { object = reinterpret_cast<uint64_t *>(object[0] | object[7]); }
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    if (object == nullptr) { std::cout << std::endl; } // Keep the walk from being optimised away
+
+    memoryManager.shutdown();
+    return elapsed.count() / (static_cast<double>(order.size()) * repetitions);
+}
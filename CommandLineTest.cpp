@@ -1,4 +1,6 @@
 #include "MemoryManager/MemoryManager.h"
+#include "MemoryManager/MemoryResource.h"
+#include "MemoryManager/ObjectPool.h"
 #include <string>
 #include <cmath>
 #include <array>
@@ -6,6 +8,15 @@
 #include <fstream>
 #include <vector>
 #include <iostream>
+#include <memory_resource>
+#include <thread>
+#include <iterator>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstring>
+#include <future>
 
 
 
@@ -20,6 +31,30 @@ unsigned int testRepeatedShutdown();
 unsigned int testMaxInitialization();
 unsigned int testGetters();
 unsigned int testReadingUsingGetMemoryStart();
+unsigned int testArenaReset();
+unsigned int testMemoryResource();
+unsigned int testRemoteFree();
+unsigned int testTracing();
+unsigned int testBitmapEngine();
+unsigned int testListIntoBuffer();
+unsigned int testBitmapIntoBuffer();
+unsigned int testSharedHeap();
+unsigned int testTagSweep();
+unsigned int testAdaptiveRestore();
+unsigned int testDirectMapping();
+unsigned int testRecording();
+unsigned int testParallelReports();
+unsigned int testObjectPool();
+unsigned int testSizedFree();
+unsigned int testAsyncWait();
+unsigned int testIndexedPolicy();
+unsigned int testZeroTracking();
+unsigned int testLifetimePlacement();
+unsigned int testAllocateNear();
+unsigned int testHeapSummary();
+unsigned int testUsageLimits();
+unsigned int testReinitialize();
+unsigned int testBoundaryPlacement();
 
 
 // helper functions
@@ -29,6 +64,7 @@ unsigned int testGetList(MemoryManager& memoryManager, uint16_t correctListLengt
 unsigned int testGetWordSize(MemoryManager& memoryManager, size_t correctWordSize);
 unsigned int testGetMemoryLimit(MemoryManager& memoryManager, size_t correctMemoryLimit);
 unsigned int testDumpMemoryMap(MemoryManager& memoryManager, std::string fileName, std::string correctFileContents);
+unsigned int testRecordedOps(std::string fileName, std::vector<uint64_t> correctOps);
 
 int hopesAndDreamsAllocator(int sizeInWords, void* list)
 {
@@ -78,7 +114,7 @@ int hopesAndDreamsAllocator(int sizeInWords, void* list)
 
 int main()
 {
-    unsigned int maxScore = 38;
+    unsigned int maxScore = 83;
     unsigned int score = 0;
     
     score += testMemoryLeaksNoShutdown(); // 0
@@ -108,7 +144,78 @@ int main()
     std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
     
     score += 5 * testReadingUsingGetMemoryStart(); // 1 * 5
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testArenaReset(); // 2
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testMemoryResource(); // 3
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testRemoteFree(); // 3
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testTracing(); // 1
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testBitmapEngine(); // 2
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testListIntoBuffer(); // 1
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testBitmapIntoBuffer(); // 1
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testSharedHeap(); // 3
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testTagSweep(); // 2
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testAdaptiveRestore(); // 2
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testDirectMapping(); // 1
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testRecording(); // 2
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testParallelReports(); // 2
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testObjectPool(); // 2
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testSizedFree(); // 2
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testAsyncWait(); // 2
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testIndexedPolicy(); // 1
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testZeroTracking(); // 1
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testLifetimePlacement(); // 1
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testAllocateNear(); // 1
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testHeapSummary(); // 2
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testUsageLimits(); // 3
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
+    
+    score += testReinitialize(); // 3
+    std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
     
+    score += testBoundaryPlacement(); // 2
     std::cout << "Score: " << score << " / " <<  maxScore << std::endl;
 }
 
@@ -605,114 +712,178 @@ unsigned int testReadingUsingGetMemoryStart()
 }
 
 
-std::string vectorToString(const std::vector<uint16_t>& vector)
+unsigned int testArenaReset()
 {
-    std::string vectorString = "";
+    std::cout << "Test Case: arena mode, reset to a marker and reset everything" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 20;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
 
-    vectorString += "[" + std::to_string(vector[0]) + ", " + std::to_string(vector[1]);
-    for (int i = 2; i < vector.size(); i +=2)
-    {
-        vectorString += "] - [" + std::to_string(vector[i]) + ", " + std::to_string(vector[i + 1]);
+    uint64_t* testArray1 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 4));
+
+    memoryManager.setArenaMode(true);
+    size_t marker = memoryManager.mark();
+
+    uint64_t* testArray2 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 2));
+    uint64_t* testArray3 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 3));
+
+    // Everything above the marker goes away, so the next block reuses its space
+    memoryManager.resetTo(marker);
+    uint64_t* testArray4 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 2));
+
+    unsigned int score = 0;
+    if(testArray1 && testArray3 && (testArray4 == testArray2)) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        ++score;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
     }
-    vectorString += "]";
 
-    return vectorString;
+    memoryManager.resetAll();
+
+    std::vector<uint16_t> correctList = {4, 16};
+    score += testGetList(memoryManager, correctList.size() * 2, correctList);
+
+    memoryManager.shutdown();
+
+    return score;
 }
 
 
-unsigned int testGetBitmap(MemoryManager& memoryManager, uint16_t correctBitmapLength, std::vector<uint8_t> correctBitmap)
+unsigned int testMemoryResource()
 {
-    unsigned int score = 0;
-    uint8_t* bitmap = static_cast<uint8_t*>(memoryManager.getBitmap());
-    uint8_t* bitmapEntryPoint = bitmap;
+    std::cout << "Test Case: pmr vector backed by the Memory Manager" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 64;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
 
-    uint8_t lowerByte = *bitmap++;
-    uint8_t higherByte = *bitmap++;
-    uint16_t byteStreamLength = (higherByte << 8) | lowerByte;
+    bool insideBlock = false;
+    {
+        MemoryManagerResource resource(memoryManager);
+        std::pmr::vector<uint64_t> values(&resource);
+        for(uint64_t i = 0; i < 10; ++i) {
+            values.push_back(i);
+        }
 
-    std::cout << "Testing getBitmap" << std::endl;
-    std::cout << "Expected: " << std::endl;
-    std::cout << "[0x" << std::hex << (int)correctBitmap[0];
+        uint8_t* memoryStart = static_cast<uint8_t*>(memoryManager.getMemoryStart());
+        uint8_t* data = reinterpret_cast<uint8_t*>(values.data());
+        insideBlock = (data >= memoryStart) && (data < memoryStart + memoryManager.getMemoryLimit()) && (values[9] == 9);
+    }
 
-    for(uint16_t i = 1; i < correctBitmap.size(); ++i) {
-        std::cout << ", 0x" << std::hex << (int)correctBitmap[i];
+    unsigned int score = 0;
+    if(insideBlock) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        ++score;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
     }
-    std::cout << "]" << std::endl;
 
+    // The vector gave everything back
+    std::vector<uint16_t> correctList = {0, 64};
+    score += testGetList(memoryManager, correctList.size() * 2, correctList);
 
-    std::cout << "\n";
-    std::cout << "Got:"  << std::endl;
-    std::cout << "[0x" << std::hex << (int)bitmap[0];
-    for(uint16_t i = 1; i < byteStreamLength; ++i) {
-        std::cout << ", 0x" << std::hex << (int)bitmap[i];
+    // Freed node-sized blocks are reused for the same size class, and handed back when the heap runs short
+    bool reused = false;
+    void* testArray1 = nullptr;
+    {
+        MemoryManagerResource resource(memoryManager);
+        void* node = resource.allocate(24);
+        resource.deallocate(node, 24);
+        reused = (resource.allocate(32) == node);
+        resource.deallocate(node, 32);
+
+        testArray1 = memoryManager.allocate(sizeof(uint64_t) * 64);
+        if(testArray1) {
+            memoryManager.free(testArray1);
+        }
     }
-    std::cout << "]" << std::endl;
 
-    for(uint16_t i = 0; i < byteStreamLength; ++i) {
-        if(bitmap[i] != correctBitmap[i]) {
-            delete [] bitmapEntryPoint;
-            std::cout << "[INCORRECT]\n" << std::endl;
-            return score;
-        }
+    if(reused && testArray1) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        ++score;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
     }
 
-    ++score;
-    delete [] bitmapEntryPoint;
-    std::cout << "[CORRECT]\n" << std::endl;
+    memoryManager.shutdown();
+
     return score;
 }
 
 
-unsigned int testGetList(MemoryManager& memoryManager, uint16_t correctListLength, std::vector<uint16_t> correctList)
+unsigned int testRemoteFree()
 {
-    unsigned int score = 0;
-    std::cout << std::dec << std::endl;
-    uint16_t* list = static_cast<uint16_t*>(memoryManager.getList());
-    uint16_t* listEntryPoint = list;
+    std::cout << "Test Case: free from another thread is drained by the owner" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 20;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
 
-    uint16_t listLength = *list++;
+    uint64_t* testArray1 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 5));
+    uint64_t* testArray2 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 5));
 
-    uint16_t bytesPerEntry = 2;
-    uint16_t entriesInList = listLength * bytesPerEntry;
+    std::thread freeingThread([&memoryManager, testArray1]() { memoryManager.free(testArray1); });
+    freeingThread.join();
 
-    std::cout << "Testing getList" << std::endl;
-    std::cout << "Expected: " << std::endl;
-    std::cout << std::dec << "[" << correctList[0];
-    for(uint16_t i = 1; i < correctList.size(); ++i) {
-        std::cout <<"] - [" << correctList[i];
-    }
-    std::cout << "]" << std::endl;
+    // The free is queued until the owning thread next allocates
+    std::vector<uint16_t> correctListBeforeDrain = {10, 10};
+    unsigned int score = 0;
+    score += testGetList(memoryManager, correctListBeforeDrain.size() * 2, correctListBeforeDrain);
 
+    uint64_t* testArray3 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 1));
 
-    std::cout << "\n";
-    std::cout << "Got:"  << std::endl;
-    std::cout << std::dec << "[" << list[0];
-    for(uint16_t i = 1; i < entriesInList; ++i) {
-        std::cout <<"] - [" << list[i];
-    }
-    std::cout << "]" << std::endl;
+    std::vector<uint16_t> correctListAfterDrain = {1, 4, 10, 10};
+    score += testGetList(memoryManager, correctListAfterDrain.size() * 2, correctListAfterDrain);
 
-    for(uint16_t i = 0; i < entriesInList; ++i) {
-        if(list[i] != correctList[i]) {
-            delete [] listEntryPoint;
-            std::cout << "[INCORRECT]\n" << std::endl;
-            return score;
-        }
+    if(testArray2 && (testArray3 == testArray1)) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        ++score;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
     }
 
-    ++score;
+    memoryManager.shutdown();
 
-    delete [] listEntryPoint;
-    std::cout << "[CORRECT]\n" << std::endl;
     return score;
 }
 
-unsigned int testGetWordSize(MemoryManager& memoryManager, size_t correctWordSize)
+
+unsigned int testTracing()
 {
-    std::cout << "Testing getWordSize" << std::endl;
-    std::cout << "Expected: " << correctWordSize << std::endl;
-    std::cout << "Got:" << memoryManager.getWordSize() << std::endl;
-    if(memoryManager.getWordSize() == correctWordSize) {
+    std::cout << "Test Case: trace events exported in Chrome trace format" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 20;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
+
+    memoryManager.setTracing(true);
+
+    uint64_t* testArray1 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 4));
+    memoryManager.free(testArray1);
+
+    int exported = memoryManager.exportTrace((char*)"testTracing.json");
+
+    memoryManager.shutdown();
+
+#ifdef MEMORY_MANAGER_TRACE
+    // One allocate and one free event, both for the 4 word block at offset 0
+    std::ifstream traceFile("testTracing.json");
+    std::string trace((std::istreambuf_iterator<char>(traceFile)), std::istreambuf_iterator<char>());
+    bool correct = (exported == 0) && (trace.find("{\"traceEvents\":[") == 0)
+        && (trace.find("\"name\":\"allocate\"") != std::string::npos) && (trace.find("\"name\":\"free\"") != std::string::npos)
+        && (trace.find("\"size\":4,\"offset\":0") != std::string::npos);
+#else
+    // Without tracing compiled in there is nothing to export
+    bool correct = (exported == -1);
+#endif
+
+    if(correct) {
         std::cout << "[CORRECT]\n" << std::endl;
         return 1;
     }
@@ -722,45 +893,1036 @@ unsigned int testGetWordSize(MemoryManager& memoryManager, size_t correctWordSiz
     }
 }
 
-unsigned int testGetMemoryLimit(MemoryManager& memoryManager, size_t correctMemoryLimit)
+
+unsigned int testBitmapEngine()
 {
-    std::cout << "Testing getMemoryLimit" << std::endl;
-    std::cout << "Expected: " << correctMemoryLimit << std::endl;
-    std::cout << "Got:" << memoryManager.getMemoryLimit() << std::endl;
-    if(memoryManager.getMemoryLimit() == correctMemoryLimit) {
+    std::cout << "Test Case: bitmap engine finds a free run past a hole that is too small" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 200;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
+    memoryManager.setBitmapEngine(true);
+
+    uint64_t* testArray1 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 60));
+    uint64_t* testArray2 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 10));
+    uint64_t* testArray3 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 100));
+
+    memoryManager.free(testArray2);
+
+    // The 10 word hole at 60 is too small, so the run starts at 170 (across a 64 word boundary)
+    uint64_t* testArray4 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 20));
+    uint64_t* memoryStart = static_cast<uint64_t*>(memoryManager.getMemoryStart());
+
+    unsigned int score = 0;
+    if(testArray1 && testArray3 && (testArray4 == memoryStart + 170) && (memoryManager.getSummary().freeWords == 20)) {
         std::cout << "[CORRECT]\n" << std::endl;
-        return 1;
+        ++score;
     }
     else {
         std::cout << "[INCORRECT]\n" << std::endl;
-        return 0;
     }
+
+    std::vector<uint16_t> correctList = {60, 10, 190, 10};
+    score += testGetList(memoryManager, correctList.size() * 2, correctList);
+
+    memoryManager.shutdown();
+
+    return score;
 }
 
-unsigned int testDumpMemoryMap(MemoryManager& memoryManager, std::string fileName, std::string correctFileContents)
+
+unsigned int testListIntoBuffer()
 {
-    std::cout << "Testing dumpMemoryMap" << std::endl;
-  
-    memoryManager.dumpMemoryMap((char*)fileName.c_str());
-    std::ifstream testFile(fileName);
-    if (testFile.is_open()) {
-        std::string line;
-        std::getline(testFile, line);
-        testFile.close();
-        std::cout << "Expected: " << correctFileContents << std::endl;
-        std::cout << "Got:" << line << std::endl;
-        if(line == correctFileContents) {
-            std::cout << "[CORRECT]\n" << std::endl;
-            return 1;
-        }
-        else {
-            std::cout << "[INCORRECT]\n" << std::endl;
-            return 0;
-        }
+    std::cout << "Test Case: getList into a caller buffer, clipped to a range" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 30;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
+
+    uint64_t* testArray1 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 5));
+    uint64_t* testArray2 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 5));
+    uint64_t* testArray3 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 5));
+
+    memoryManager.free(testArray2);
+
+    // A buffer that is too small only reports the length it needs
+    uint16_t buffer[5] = {0, 0, 0, 0, 0};
+    size_t required = memoryManager.getList(buffer, 1);
+    size_t written = memoryManager.getList(buffer, 5, 7, 6);
+
+    memoryManager.shutdown();
+
+    if(testArray1 && testArray3 && (required == 5) && (written == 3) && (buffer[0] == 1) && (buffer[1] == 7) && (buffer[2] == 3)) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        return 1;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+        return 0;
     }
-    return 0;
 }
 
 
+unsigned int testBitmapIntoBuffer()
+{
+    std::cout << "Test Case: getBitmap into a caller buffer, clipped to a range" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 30;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
+
+    uint64_t* testArray1 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 5));
+    uint64_t* testArray2 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 5));
+    uint64_t* testArray3 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 5));
+
+    memoryManager.free(testArray2);
+
+    // Words 3 to 12: two used, five free, three used
+    std::vector<uint8_t> correctBuffer{0x02, 0x00, 0x83, 0x03};
+
+    // A buffer that is too small only reports the length it needs
+    uint8_t buffer[4] = {0, 0, 0, 0};
+    size_t required = memoryManager.getBitmap(buffer, 2, 3, 10);
+    bool untouched = (buffer[0] == 0);
+
+    size_t written = memoryManager.getBitmap(buffer, 4, 3, 10);
+    bool holeListCorrect = (written == 4) && std::equal(correctBuffer.begin(), correctBuffer.end(), buffer);
 
+    // The bitmap engine answers from its own bitmap
+    memoryManager.setBitmapEngine(true);
+    std::fill(buffer, buffer + 4, 0);
+    memoryManager.getBitmap(buffer, 4, 3, 10);
+    bool bitmapEngineCorrect = std::equal(correctBuffer.begin(), correctBuffer.end(), buffer);
 
+    memoryManager.shutdown();
+
+    if(testArray1 && testArray3 && (required == 4) && untouched && holeListCorrect && bitmapEngineCorrect) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        return 1;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+        return 0;
+    }
+}
+
+
+unsigned int testSharedHeap()
+{
+    std::cout << "Test Case: shared heap, allocate in one manager and free in another" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 32;
+    MemoryManager creator(wordSize, bestFit);
+    MemoryManager attached(wordSize, bestFit);
+
+    if((creator.initializeShared("/CommandLineTestShared", numberOfWords) != 0) || (attached.attachShared("/CommandLineTestShared") != 0)) {
+        std::cout << "[INCORRECT]\n" << std::endl;
+        return 0;
+    }
+
+    uint64_t* testArray1 = static_cast<uint64_t*>(creator.allocate(sizeof(uint64_t) * 4));
+    testArray1[0] = 42;
+
+    // Addresses differ between mappings, offsets do not
+    uint64_t* testArray1Attached = static_cast<uint64_t*>(attached.addressOf(creator.offsetOf(testArray1)));
+    bool sameContents = (testArray1Attached[0] == 42);
+
+    attached.free(testArray1Attached);
+
+    unsigned int score = 0;
+    if(sameContents) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        ++score;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+    }
+
+    std::vector<uint16_t> correctList = {0, 32};
+    score += testGetList(creator, correctList.size() * 2, correctList);
+
+    attached.shutdown();
+    creator.shutdown();
+
+    // A segment cut down to its first page, short of its memory block, is refused
+    MemoryManager truncated(wordSize, bestFit);
+    MemoryManager refused(wordSize, bestFit);
+    truncated.initializeShared("/CommandLineTestTruncated", 4096);
+    int sharedFile = shm_open("/CommandLineTestTruncated", O_RDWR, 0600);
+    bool cut = (sharedFile != -1) && (ftruncate(sharedFile, 4096) == 0);
+    if(sharedFile != -1) {
+        close(sharedFile);
+    }
+
+    if(cut && (refused.attachShared("/CommandLineTestTruncated") == -1)) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        ++score;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+    }
+    truncated.shutdown();
+
+    return score;
+}
+
+
+unsigned int testTagSweep()
+{
+    std::cout << "Test Case: free every block with a tag" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 30;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
+
+    uint64_t* testArray1 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 4, uint8_t(1)));
+    uint64_t* testArray2 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 4, uint8_t(2)));
+    uint64_t* testArray3 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 4, uint8_t(1)));
+
+    unsigned int score = 0;
+    bool taggedBefore = testArray1 && testArray2 && testArray3 && (memoryManager.getTagBytes(1) == sizeof(uint64_t) * 8);
+
+    memoryManager.freeAllWithTag(1);
+
+    if(taggedBefore && (memoryManager.getTagBytes(1) == 0) && (memoryManager.getTagBytes(2) == sizeof(uint64_t) * 4)) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        ++score;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+    }
+
+    std::vector<uint16_t> correctList = {0, 4, 8, 22};
+    score += testGetList(memoryManager, correctList.size() * 2, correctList);
+
+    memoryManager.shutdown();
+
+    return score;
+}
+
+
+unsigned int testAdaptiveRestore()
+{
+    std::cout << "Test Case: turning adaptive selection off restores the allocator" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 30;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
+
+    uint64_t* testArray1 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 5));
+    uint64_t* testArray2 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 1));
+
+    memoryManager.free(testArray1);
+
+    memoryManager.setAllocator(worstFit);
+    memoryManager.setAdaptive(true);
+    memoryManager.setAdaptive(false);
+
+    // worstFit takes the 24 word tail hole over the 5 word hole at the start
+    uint64_t* testArray3 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 2));
+
+    // The bitmap engine turns adaptive selection off and keeps it off
+    memoryManager.setAdaptive(true);
+    memoryManager.setBitmapEngine(true);
+    bool offWithBitmap = !memoryManager.getStats().adaptive;
+    memoryManager.setAdaptive(true);
+    offWithBitmap = offWithBitmap && !memoryManager.getStats().adaptive;
+
+    memoryManager.shutdown();
+
+    unsigned int score = 0;
+    if(testArray2 && (testArray3 == testArray2 + 1)) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        ++score;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+    }
+
+    if(offWithBitmap) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        ++score;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+    }
+
+    return score;
+}
+
+
+unsigned int testDirectMapping()
+{
+    std::cout << "Test Case: large blocks are mapped outside the memory block" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 20;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
+    memoryManager.setDirectMapThreshold(4096);
+
+    uint64_t* testArray1 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 1024));
+    bool mapped = testArray1 && (memoryManager.getStats().directMappedCount == 1);
+    if(mapped) {
+        testArray1[1023] = 1;
+    }
+
+    memoryManager.free(testArray1);
+    bool unmapped = (memoryManager.getStats().directMappedCount == 0) && (memoryManager.getStats().freeWords == numberOfWords);
+
+    memoryManager.shutdown();
+
+    if(mapped && unmapped) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        return 1;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+        return 0;
+    }
+}
+
+
+unsigned int testRecording()
+{
+    std::cout << "Test Case: recorded trace replays every allocation and free" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 40;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
+
+    // Blocks live before recording starts open the trace
+    uint64_t* testArray1 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 10));
+
+    memoryManager.startRecording((char*)"testRecording.bin");
+
+    uint64_t* testArray2 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 4, uint8_t(1)));
+    uint64_t* testArray3 = static_cast<uint64_t*>(memoryManager.allocateAligned(sizeof(uint64_t) * 2, 64));
+    memoryManager.allocate(sizeof(uint64_t) * 30);
+    memoryManager.free(testArray1);
+    memoryManager.freeAllWithTag(1);
+    memoryManager.free(testArray3);
+
+    memoryManager.stopRecording();
+    memoryManager.shutdown();
+
+    std::vector<uint64_t> correctOps = {
+        0, 10, 0,   // Live before recording
+        0, 4, 10,   // allocate
+        0, 2, 16,   // allocateAligned (64 bytes is 8 words)
+        2, 30, 0,   // failed allocate
+        1, 10, 0,   // free
+        1, 4, 10,   // freeAllWithTag
+        1, 2, 16    // free of the aligned block
+    };
+
+    unsigned int score = 0;
+    score += (testArray2 != nullptr);
+    score += testRecordedOps("testRecording.bin", correctOps);
+
+    return score;
+}
+
+
+unsigned int testParallelReports()
+{
+    std::cout << "Test Case: parallel bitmap and memory map match the serial ones" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 60000;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
+
+    std::vector<void*> blocks;
+    for(uint16_t i = 0; i < 1000; ++i) {
+        blocks.push_back(memoryManager.allocate(sizeof(uint64_t) * 30));
+    }
+    for(uint16_t i = 0; i < 1000; i += 3) {
+        memoryManager.free(blocks[i]);
+    }
+
+    // More threads than cores are clamped, the result is the same
+    uint8_t* bitmap = static_cast<uint8_t*>(memoryManager.getBitmap());
+    uint8_t* parallelBitmap = static_cast<uint8_t*>(memoryManager.getBitmapParallel(64).get());
+    size_t bitmapLength = 2 + ((numberOfWords + 7) / 8);
+    bool sameBitmap = bitmap && parallelBitmap && std::equal(bitmap, bitmap + bitmapLength, parallelBitmap);
+
+    memoryManager.dumpMemoryMap((char*)"testParallelReports.txt");
+    int dumped = memoryManager.dumpMemoryMapParallel((char*)"testParallelReportsParallel.txt", 64).get();
+
+    std::ifstream serialFile("testParallelReports.txt");
+    std::ifstream parallelFile("testParallelReportsParallel.txt");
+    std::string serialMap((std::istreambuf_iterator<char>(serialFile)), std::istreambuf_iterator<char>());
+    std::string parallelMap((std::istreambuf_iterator<char>(parallelFile)), std::istreambuf_iterator<char>());
+
+    delete [] bitmap;
+    delete [] parallelBitmap;
+    memoryManager.shutdown();
+
+    unsigned int score = 0;
+    if(sameBitmap) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        ++score;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+    }
+
+    if((dumped == 0) && !serialMap.empty() && (serialMap == parallelMap)) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        ++score;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+    }
+
+    return score;
+}
+
+
+unsigned int testObjectPool()
+{
+    std::cout << "Test Case: object pool hands memory back when destroyed" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 256;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
+
+    bool created = true;
+    {
+        ObjectPool<uint64_t> pool(memoryManager, 256);
+        std::vector<uint64_t*> objects;
+        for(uint64_t i = 0; i < 40; ++i) {
+            objects.push_back(pool.create(i));
+            created = created && objects.back() && (*objects.back() == i);
+        }
+        for(auto object: objects) {
+            pool.destroy(object);
+        }
+    }
+
+    unsigned int score = 0;
+    if(created) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        ++score;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+    }
+
+    std::vector<uint16_t> correctList = {0, 256};
+    score += testGetList(memoryManager, correctList.size() * 2, correctList);
+
+    memoryManager.shutdown();
+
+    return score;
+}
+
+
+unsigned int testSizedFree()
+{
+    std::cout << "Test Case: sized free and ownership check" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 20;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
+
+    uint64_t* testArray1 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 5));
+    uint64_t* testArray2 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 5));
+
+    bool ownedBefore = memoryManager.owns(testArray1) && !memoryManager.owns(testArray1 + 1);
+
+    memoryManager.free(testArray1, sizeof(uint64_t) * 5);
+
+    unsigned int score = 0;
+    if(testArray2 && ownedBefore && !memoryManager.owns(testArray1) && (memoryManager.getStats().allocationCount == 1)) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        ++score;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+    }
+
+    std::vector<uint16_t> correctList = {0, 5, 10, 10};
+    score += testGetList(memoryManager, correctList.size() * 2, correctList);
+
+    memoryManager.shutdown();
+
+    return score;
+}
+
+
+unsigned int testAsyncWait()
+{
+    std::cout << "Test Case: waiting and async allocation on a full heap" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 10;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
+
+    uint64_t* testArray1 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 10));
+
+    // Nothing frees while waiting, so the wait times out
+    void* timedOut = memoryManager.allocateWait(sizeof(uint64_t), std::chrono::milliseconds(10));
+
+    // The queued request is served by the free
+    std::future<void*> pending = memoryManager.allocateAsync(sizeof(uint64_t) * 4);
+    memoryManager.free(testArray1);
+
+    bool served = (pending.wait_for(std::chrono::seconds(1)) == std::future_status::ready) && (pending.get() == testArray1);
+    memoryManager.free(testArray1);
+
+    // A waiter on another thread wakes as soon as the owner frees, well before its timeout
+    uint64_t* testArray2 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 10));
+    auto start = std::chrono::steady_clock::now();
+    std::future<void*> waited = std::async(std::launch::async, [&memoryManager]() { return memoryManager.allocateWait(sizeof(uint64_t) * 2, std::chrono::seconds(5)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    memoryManager.free(testArray2);
+
+    bool woken = (waited.get() == testArray2) && ((std::chrono::steady_clock::now() - start) < std::chrono::seconds(2));
+
+    memoryManager.shutdown();
+
+    if(!timedOut && served && woken) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        return 2;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+        return 0;
+    }
+}
+
+
+unsigned int testIndexedPolicy()
+{
+    std::cout << "Test Case: IndexedBestFit policy places blocks exactly like bestFit" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 1000;
+    MemoryManager bestFitManager(wordSize, bestFit);
+    MemoryManager policyManager(wordSize, bestFit);
+    bestFitManager.initialize(numberOfWords);
+    policyManager.initialize(numberOfWords);
+
+    IndexedBestFit policy;
+    policyManager.setAllocatorPolicy(&policy);
+
+    // The same mix of allocations and frees on both managers
+    std::vector<uint8_t*> bestFitBlocks;
+    std::vector<uint8_t*> policyBlocks;
+    uint32_t random = 12345;
+    bool samePlacement = true;
+    for(uint16_t i = 0; i < 400; ++i) {
+        random = (random * 1103515245) + 12345;
+        if(((random >> 16) % 3 == 0) && !bestFitBlocks.empty()) {
+            size_t index = (random >> 8) % bestFitBlocks.size();
+            bestFitManager.free(bestFitBlocks[index]);
+            policyManager.free(policyBlocks[index]);
+            bestFitBlocks.erase(bestFitBlocks.begin() + index);
+            policyBlocks.erase(policyBlocks.begin() + index);
+            continue;
+        }
+
+        size_t sizeInBytes = sizeof(uint64_t) * (1 + ((random >> 20) % 24));
+        uint8_t* bestFitBlock = static_cast<uint8_t*>(bestFitManager.allocate(sizeInBytes));
+        uint8_t* policyBlock = static_cast<uint8_t*>(policyManager.allocate(sizeInBytes));
+        if(!bestFitBlock || !policyBlock) {
+            samePlacement = samePlacement && (bestFitBlock == policyBlock);
+            continue;
+        }
+
+        samePlacement = samePlacement && (bestFitManager.offsetOf(bestFitBlock) == policyManager.offsetOf(policyBlock));
+        bestFitBlocks.push_back(bestFitBlock);
+        policyBlocks.push_back(policyBlock);
+    }
+
+    uint16_t* bestFitList = static_cast<uint16_t*>(bestFitManager.getList());
+    uint16_t* policyList = static_cast<uint16_t*>(policyManager.getList());
+    bool sameList = (bestFitList[0] == policyList[0]) && std::equal(bestFitList, bestFitList + 1 + (bestFitList[0] * 2), policyList);
+
+    delete [] bestFitList;
+    delete [] policyList;
+    policyManager.shutdown();
+    bestFitManager.shutdown();
+
+    if(samePlacement && sameList) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        return 1;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+        return 0;
+    }
+}
+
+
+unsigned int testZeroTracking()
+{
+    std::cout << "Test Case: allocateZeroed clears reused memory" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 20;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
+
+    uint64_t* testArray1 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 10));
+    memset(testArray1, 0xFF, sizeof(uint64_t) * 10);
+    memoryManager.free(testArray1);
+
+    uint64_t* testArray2 = static_cast<uint64_t*>(memoryManager.allocateZeroed(sizeof(uint64_t) * 10));
+
+    bool zeroed = (testArray2 == testArray1);
+    for(uint16_t i = 0; zeroed && (i < 10); ++i) {
+        zeroed = (testArray2[i] == 0);
+    }
+
+    memoryManager.shutdown();
+
+    if(zeroed) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        return 1;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+        return 0;
+    }
+}
+
+
+unsigned int testLifetimePlacement()
+{
+    std::cout << "Test Case: long-lived blocks go low, short-lived blocks go high" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 20;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
+
+    memoryManager.allocate(sizeof(uint64_t) * 2, Lifetime::Long);
+    memoryManager.allocate(sizeof(uint64_t) * 3, Lifetime::Short);
+
+    std::vector<uint16_t> correctList = {2, 15};
+    unsigned int score = testGetList(memoryManager, correctList.size() * 2, correctList);
+
+    memoryManager.shutdown();
+
+    return score;
+}
+
+
+unsigned int testAllocateNear()
+{
+    std::cout << "Test Case: allocateNear picks the hole closest to the hint" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 40;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
+
+    uint64_t* testArray1 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 2));
+    uint64_t* testArray2 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 10));
+    uint64_t* testArray3 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 10));
+    uint64_t* testArray4 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 2));
+
+    memoryManager.free(testArray1);
+    memoryManager.free(testArray4);
+
+    // bestFit would take the hole at 0; the hole at 22 touches the hint's block
+    uint64_t* testArray5 = static_cast<uint64_t*>(memoryManager.allocateNear(testArray3, sizeof(uint64_t) * 2));
+
+    memoryManager.shutdown();
+
+    if(testArray2 && (testArray5 == testArray4)) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        return 1;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+        return 0;
+    }
+}
+
+
+unsigned int testHeapSummary()
+{
+    std::cout << "Test Case: published heap summary" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 30;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
+
+    uint64_t* testArray1 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 5));
+    uint64_t* testArray2 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 5));
+
+    memoryManager.free(testArray1);
+
+    HeapSummary summary = memoryManager.getSummary();
+
+    unsigned int score = 0;
+    if(testArray2 && (summary.freeWords == 25) && (summary.largestHole == 20) && (summary.holeCount == 2)) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        ++score;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+    }
+
+    // The bitmap engine keeps the summary current without rebuilding the holes
+    memoryManager.reinitialize(1000);
+    memoryManager.setBitmapEngine(true);
+    uint64_t* testArray3 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 900));
+    uint64_t* testArray4 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 50));
+    memoryManager.free(testArray3);
+
+    summary = memoryManager.getSummary();
+
+    memoryManager.shutdown();
+
+    if(testArray4 && (summary.freeWords == 950) && (summary.largestHole == 900) && (summary.holeCount == 2)) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        ++score;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+    }
+
+    return score;
+}
+
+
+unsigned int testUsageLimits()
+{
+    std::cout << "Test Case: hard limit on every allocation path, then pressure relief" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 20;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
+
+    memoryManager.setUsageLimits(0, sizeof(uint64_t) * 10);
+
+    uint64_t* testArray1 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 8));
+    void* overLimit = memoryManager.allocate(sizeof(uint64_t) * 4);
+    void* overLimitNear = memoryManager.allocateNear(testArray1, sizeof(uint64_t) * 4);
+    void* overLimitAligned = memoryManager.allocateAligned(sizeof(uint64_t) * 4, 64);
+
+    unsigned int score = 0;
+    if(testArray1 && !overLimit && !overLimitNear && !overLimitAligned) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        ++score;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+    }
+
+    // With the heap full, the callback frees a block and the allocation is retried
+    memoryManager.setUsageLimits(0, 0);
+    uint64_t* testArray2 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 12));
+    memoryManager.addPressureCallback([&memoryManager, &testArray2](size_t) {
+        memoryManager.free(testArray2);
+        testArray2 = nullptr;
+    });
+
+    void* relieved = memoryManager.allocateNear(testArray1, sizeof(uint64_t) * 4);
+
+    if(relieved && !testArray2) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        ++score;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+    }
+
+    // Direct mappings count toward usage and go through the same limits
+    memoryManager.setDirectMapThreshold(4096);
+    memoryManager.setUsageLimits(0, 8192);
+    void* directArray1 = memoryManager.allocate(4096);
+    void* directArray2 = memoryManager.allocate(4096);
+
+    if(directArray1 && !directArray2 && (memoryManager.getStats().directMappedBytes == 4096)) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        ++score;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+    }
+
+    memoryManager.shutdown();
+
+    return score;
+}
+
+
+unsigned int testReinitialize()
+{
+    std::cout << "Test Case: reinitialize within and above capacity" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 20;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
+
+    uint64_t* testArray1 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 5));
+
+    // Within capacity the block is reused
+    memoryManager.reinitialize(10);
+
+    unsigned int score = 0;
+    std::vector<uint16_t> correctList = {0, 10};
+    score += testGetList(memoryManager, correctList.size() * 2, correctList);
+    score += testGetMemoryLimit(memoryManager, wordSize * 10);
+
+    // Above capacity the block is remapped, and arena mode stays on
+    memoryManager.setArenaMode(true);
+    memoryManager.reinitialize(40);
+    uint64_t* testArray2 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 1));
+
+    if(testArray1 && testArray2 && (memoryManager.mark() == 1) && (memoryManager.getMemoryLimit() == wordSize * 40)) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        ++score;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+    }
+
+    memoryManager.shutdown();
+
+    return score;
+}
+
+
+unsigned int testBoundaryPlacement()
+{
+    std::cout << "Test Case: boundary-aware placement keeps small blocks inside a cache line" << std::endl;
+    unsigned int wordSize = 8;
+    size_t numberOfWords = 64;
+    MemoryManager memoryManager(wordSize, bestFit);
+    memoryManager.initialize(numberOfWords);
+
+    // Off by default: the 64 byte block goes straight after the first word and crosses a line
+    uint64_t* testArray1 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 1));
+    uint64_t* testArray2 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 8));
+    bool straddled = (testArray2 == testArray1 + 1) && (memoryManager.getStats().lineStraddlingBlocks == 1);
+
+    // Freeing it drops the count; with the threshold set the block moves up to the next line
+    memoryManager.free(testArray2);
+    bool counted = straddled && (memoryManager.getStats().lineStraddlingBlocks == 0);
+    memoryManager.setBoundaryThreshold(64);
+    uint64_t* testArray3 = static_cast<uint64_t*>(memoryManager.allocate(sizeof(uint64_t) * 8));
+    MemoryStats stats = memoryManager.getStats();
+
+    unsigned int score = 0;
+    if(counted && (testArray3 == testArray1 + 8) && (stats.lineStraddlingBlocks == 0) && (stats.pageStraddlingBlocks == 0)) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        ++score;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+    }
+
+    // The skipped words stay a hole of their own
+    std::vector<uint16_t> correctList = {1, 7, 16, 48};
+    score += testGetList(memoryManager, correctList.size() * 2, correctList);
+
+    memoryManager.shutdown();
+
+    return score;
+}
+
+
+std::string vectorToString(const std::vector<uint16_t>& vector)
+{
+    std::string vectorString = "";
+
+    vectorString += "[" + std::to_string(vector[0]) + ", " + std::to_string(vector[1]);
+    for (int i = 2; i < vector.size(); i +=2)
+    {
+        vectorString += "] - [" + std::to_string(vector[i]) + ", " + std::to_string(vector[i + 1]);
+    }
+    vectorString += "]";
+
+    return vectorString;
+}
+
+
+unsigned int testGetBitmap(MemoryManager& memoryManager, uint16_t correctBitmapLength, std::vector<uint8_t> correctBitmap)
+{
+    unsigned int score = 0;
+    uint8_t* bitmap = static_cast<uint8_t*>(memoryManager.getBitmap());
+    uint8_t* bitmapEntryPoint = bitmap;
+
+    uint8_t lowerByte = *bitmap++;
+    uint8_t higherByte = *bitmap++;
+    uint16_t byteStreamLength = (higherByte << 8) | lowerByte;
+
+    std::cout << "Testing getBitmap" << std::endl;
+    std::cout << "Expected: " << std::endl;
+    std::cout << "[0x" << std::hex << (int)correctBitmap[0];
+
+    for(uint16_t i = 1; i < correctBitmap.size(); ++i) {
+        std::cout << ", 0x" << std::hex << (int)correctBitmap[i];
+    }
+    std::cout << "]" << std::endl;
+
+
+    std::cout << "\n";
+    std::cout << "Got:"  << std::endl;
+    std::cout << "[0x" << std::hex << (int)bitmap[0];
+    for(uint16_t i = 1; i < byteStreamLength; ++i) {
+        std::cout << ", 0x" << std::hex << (int)bitmap[i];
+    }
+    std::cout << "]" << std::endl;
+
+    for(uint16_t i = 0; i < byteStreamLength; ++i) {
+        if(bitmap[i] != correctBitmap[i]) {
+            delete [] bitmapEntryPoint;
+            std::cout << "[INCORRECT]\n" << std::endl;
+            return score;
+        }
+    }
+
+    ++score;
+    delete [] bitmapEntryPoint;
+    std::cout << "[CORRECT]\n" << std::endl;
+    return score;
+}
+
+
+unsigned int testGetList(MemoryManager& memoryManager, uint16_t correctListLength, std::vector<uint16_t> correctList)
+{
+    unsigned int score = 0;
+    std::cout << std::dec << std::endl;
+    uint16_t* list = static_cast<uint16_t*>(memoryManager.getList());
+    uint16_t* listEntryPoint = list;
+
+    uint16_t listLength = *list++;
+
+    uint16_t bytesPerEntry = 2;
+    uint16_t entriesInList = listLength * bytesPerEntry;
+
+    std::cout << "Testing getList" << std::endl;
+    std::cout << "Expected: " << std::endl;
+    std::cout << std::dec << "[" << correctList[0];
+    for(uint16_t i = 1; i < correctList.size(); ++i) {
+        std::cout <<"] - [" << correctList[i];
+    }
+    std::cout << "]" << std::endl;
+
+
+    std::cout << "\n";
+    std::cout << "Got:"  << std::endl;
+    std::cout << std::dec << "[" << list[0];
+    for(uint16_t i = 1; i < entriesInList; ++i) {
+        std::cout <<"] - [" << list[i];
+    }
+    std::cout << "]" << std::endl;
+
+    for(uint16_t i = 0; i < entriesInList; ++i) {
+        if(list[i] != correctList[i]) {
+            delete [] listEntryPoint;
+            std::cout << "[INCORRECT]\n" << std::endl;
+            return score;
+        }
+    }
+
+    ++score;
+
+    delete [] listEntryPoint;
+    std::cout << "[CORRECT]\n" << std::endl;
+    return score;
+}
+
+unsigned int testGetWordSize(MemoryManager& memoryManager, size_t correctWordSize)
+{
+    std::cout << "Testing getWordSize" << std::endl;
+    std::cout << "Expected: " << correctWordSize << std::endl;
+    std::cout << "Got:" << memoryManager.getWordSize() << std::endl;
+    if(memoryManager.getWordSize() == correctWordSize) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        return 1;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+        return 0;
+    }
+}
+
+unsigned int testGetMemoryLimit(MemoryManager& memoryManager, size_t correctMemoryLimit)
+{
+    std::cout << "Testing getMemoryLimit" << std::endl;
+    std::cout << "Expected: " << correctMemoryLimit << std::endl;
+    std::cout << "Got:" << memoryManager.getMemoryLimit() << std::endl;
+    if(memoryManager.getMemoryLimit() == correctMemoryLimit) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        return 1;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+        return 0;
+    }
+}
+
+unsigned int testDumpMemoryMap(MemoryManager& memoryManager, std::string fileName, std::string correctFileContents)
+{
+    std::cout << "Testing dumpMemoryMap" << std::endl;
+  
+    memoryManager.dumpMemoryMap((char*)fileName.c_str());
+    std::ifstream testFile(fileName);
+    if (testFile.is_open()) {
+        std::string line;
+        std::getline(testFile, line);
+        testFile.close();
+        std::cout << "Expected: " << correctFileContents << std::endl;
+        std::cout << "Got:" << line << std::endl;
+        if(line == correctFileContents) {
+            std::cout << "[CORRECT]\n" << std::endl;
+            return 1;
+        }
+        else {
+            std::cout << "[INCORRECT]\n" << std::endl;
+            return 0;
+        }
+    }
+    return 0;
+}
+
+unsigned int testRecordedOps(std::string fileName, std::vector<uint64_t> correctOps)
+{
+    std::cout << "Testing recorded trace" << std::endl;
+
+    std::ifstream traceFile(fileName, std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(traceFile)), std::istreambuf_iterator<char>());
+
+    // Varints are 7 bits per byte, low bits first
+    size_t position = 0;
+    auto readVarint = [&data, &position]() {
+        uint64_t value = 0;
+        for(unsigned int shift = 0; (position < data.size()) && (shift < 64); shift += 7) {
+            uint8_t byte = data[position++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if(!(byte & 0x80)) {
+                break;
+            }
+        }
+        return value;
+    };
+
+    // Skip the header (magic, version, word size, size in words), then collect op, size and offset of each record
+    std::vector<uint64_t> ops;
+    if((data.size() > 5) && (memcmp(data.data(), TraceRecordMagic, 4) == 0)) {
+        position = 5;
+        readVarint();
+        readVarint();
+        while(position < data.size()) {
+            uint8_t op = data[position++];
+            readVarint();
+            ops.push_back(op);
+            ops.push_back(readVarint());
+            ops.push_back((op == static_cast<uint8_t>(RecordOp::FailedAllocate)) ? 0 : readVarint());
+        }
+    }
+
+    std::cout << "Expected " << correctOps.size() / 3 << " records, got " << ops.size() / 3 << std::endl;
+
+    if(ops == correctOps) {
+        std::cout << "[CORRECT]\n" << std::endl;
+        return 1;
+    }
+    else {
+        std::cout << "[INCORRECT]\n" << std::endl;
+        return 0;
+    }
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <cstdint>
+
+struct Allocation
+{
+    uint32_t sizeInWords = 0;
+    uint8_t tag = 0; // Owner subsystem, see MemoryManager::allocate(size_t, uint8_t)
+};
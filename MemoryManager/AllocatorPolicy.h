@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <set>
+#include <utility>
+#include <vector>
+#include "Hole.h"
+
+// Stateful placement strategy for MemoryManager::setAllocatorPolicy.
+// The manager reports every change it makes to its hole list, so a policy can keep its own index
+// up to date incrementally instead of rebuilding it from getList on every allocation.
+// The manager does not own the policy; shutdown does not notify it, so it may be destroyed first.
+class AllocatorPolicy
+{
+    public:
+    virtual ~AllocatorPolicy() {}
+
+    // The whole hole list was replaced (initialize, bulk frees, shared-heap reloads)
+    virtual void onHolesReset(const std::vector<Hole> &holes) = 0;
+    virtual void onHoleCreated(const Hole &hole) = 0;
+    virtual void onHoleResized(const Hole &before, const Hole &after) = 0;
+    virtual void onHoleRemoved(const Hole &hole) = 0;
+
+    // Offset in words of a hole that fits the block, or -1 if none does
+    virtual long selectHole(size_t sizeInWords) = 0;
+};
+
+// Best fit over a (size, offset) index: O(log n) per query and per notification.
+// Picks the same hole as bestFit (smallest that fits, lowest offset on ties).
+class IndexedBestFit : public AllocatorPolicy
+{
+    public:
+    void onHolesReset(const std::vector<Hole> &holes) override;
+    void onHoleCreated(const Hole &hole) override;
+    void onHoleResized(const Hole &before, const Hole &after) override;
+    void onHoleRemoved(const Hole &hole) override;
+    long selectHole(size_t sizeInWords) override;
+
+    private:
+    std::set<std::pair<size_t, size_t>> bySize = {}; // (size, offset)
+};
@@ -0,0 +1,10 @@
+#pragma once
+#include <cstddef>
+
+// Hole summary published by MemoryManager after every allocate/free; see MemoryManager::getSummary
+struct HeapSummary
+{
+    size_t freeWords = 0;
+    size_t largestHole = 0; // In words
+    size_t holeCount = 0;
+};
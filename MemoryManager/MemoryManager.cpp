@@ -4,8 +4,159 @@
 #include <cstring>
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <cerrno>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cassert>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 
+// Start of a shared-memory heap segment; the holes, block sizes and memory block follow it
+struct SharedHeader
+{
+    std::atomic<uint64_t> magic; // Set last by the creator so attachers never see a half-built heap
+    uint32_t wordSize;
+    uint64_t sizeInWords;
+    pthread_mutex_t lock;
+    uint64_t holeCount;
+    uint64_t maxHoles;
+    uint64_t generation; // Bumped each time a process stores changed holes
+    uint64_t holesOffset; // Byte offsets from the start of the segment
+    uint64_t blockSizesOffset;
+    uint64_t memoryOffset;
+};
+
+static const uint64_t SharedMagic = 0x4D656D4D67725348; // "MemMgrSH"
+
+// Locks the shared heap and keeps the local hole copy in step with the segment.
+// Only the outermost lock on a thread loads and stores the holes, and only when they changed.
+class MemoryManager::SharedLock
+{
+    public:
+    explicit SharedLock(MemoryManager *manager) : manager(manager)
+    {
+        SharedHeader *header = manager->sharedHeader;
+        if (!header) { return; }
+
+        // A process died holding the lock: make sure it left a usable hole table before taking over
+        if (pthread_mutex_lock(&header->lock) == EOWNERDEAD)
+        {
+            if (!manager->sharedHolesValid()) { manager->rebuildSharedHoles(); }
+            pthread_mutex_consistent(&header->lock);
+        }
+
+        // Only reload when another process stored different holes since this one last saw them
+        if ((manager->sharedDepth++ == 0) && (header->generation != manager->sharedGeneration))
+        {
+            Hole *sharedHoles = reinterpret_cast<Hole *>(reinterpret_cast<uint8_t *>(header) + header->holesOffset);
+            manager->holes.assign(sharedHoles, sharedHoles + header->holeCount);
+            manager->sharedGeneration = header->generation;
+            manager->holesReset();
+            reloaded = true;
+        }
+    }
+
+    ~SharedLock()
+    {
+        SharedHeader *header = manager->sharedHeader;
+        if (!header) { return; }
+
+        if (--manager->sharedDepth == 0)
+        {
+            Hole *sharedHoles = reinterpret_cast<Hole *>(reinterpret_cast<uint8_t *>(header) + header->holesOffset);
+            bool changed = (manager->holes.size() != header->holeCount) || !std::equal(manager->holes.begin(), manager->holes.end(), sharedHoles, [](const Hole &a, const Hole &b) { return (a.offset == b.offset) && (a.size == b.size); });
+            if (changed)
+            {
+                std::copy(manager->holes.begin(), manager->holes.end(), sharedHoles);
+                header->holeCount = manager->holes.size();
+                manager->sharedGeneration = ++header->generation;
+            }
+            if (changed || reloaded) { manager->publishSummary(); }
+        }
+
+        pthread_mutex_unlock(&header->lock);
+    }
+
+    private:
+    MemoryManager *manager;
+    bool reloaded = false;
+};
+
+// Double-buffered binary trace writer: the allocating thread fills one buffer while a background thread writes the other
+struct Recorder
+{
+    static const size_t BufferSize = 64 * 1024;
+    static const size_t MaxRecord = 1 + (3 * 10); // Op byte plus three 64-bit varints
+
+    int file = -1;
+    uint8_t buffers[2][BufferSize];
+    uint8_t *active = buffers[0];
+    size_t used = 0;
+    uint8_t *pending = nullptr; // Buffer handed to the writer, null once written
+    size_t pendingUsed = 0;
+    bool stopping = false;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::thread writer;
+    std::chrono::steady_clock::time_point last;
+};
+
+// Append a base-128 varint, returning the new end of the buffer
+static uint8_t *writeVarint(uint8_t *out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        *out++ = static_cast<uint8_t>(value) | 0x80;
+        value >>= 7;
+    }
+    *out++ = static_cast<uint8_t>(value);
+
+    return out;
+}
+
+// Builds the used/free bits for words [startWord, endWord) into bitmap, where bit 0 of bitmap is startWord
+static void fillBitmapRange(const std::vector<Hole> &holes, uint8_t *bitmap, size_t startWord, size_t endWord)
+{
+    // Start with every word in the range used
+    memset(bitmap, 0xFF, ((endWord - startWord) + 7) / 8);
+
+    // Clear the bits of the holes overlapping the range
+    auto it = std::partition_point(holes.begin(), holes.end(),
+        [startWord](const Hole &hole) { return (hole.offset + hole.size) <= startWord; });
+
+    for (; (it != holes.end()) && (it->offset < endWord); ++it)
+    {
+        size_t first = std::max(it->offset, startWord) - startWord;
+        size_t end = std::min(it->offset + it->size, endWord) - startWord;
+
+        // Leading bits up to a byte boundary
+        while ((first < end) && (first % 8 != 0))
+        {
+            bitmap[first / 8] &= ~(1 << (first % 8));
+            first++;
+        }
+
+        // Whole bytes
+        size_t wholeBytes = (end - first) / 8;
+        memset(bitmap + (first / 8), 0, wholeBytes);
+        first += wholeBytes * 8;
+
+        // Trailing bits
+        while (first < end)
+        {
+            bitmap[first / 8] &= ~(1 << (first % 8));
+            first++;
+        }
+    }
+}
+
 MemoryManager::MemoryManager(unsigned wordSize, std::function<int(int, void *)> allocator)
 {
     this->wordSize = wordSize;
@@ -20,29 +171,199 @@ void MemoryManager::initialize(size_t sizeInWords)
     if (sizeInWords > 65536) { return; }
     if (memoryBlock != nullptr) { shutdown(); }
     
-    // Allocate the memory block
-    memoryBlock = new uint8_t[sizeInWords * wordSize];
+    // Map the memory block straight from the OS so it starts out zeroed
+    void *mapping = mmap(nullptr, sizeInWords * wordSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) { return; }
+    memoryBlock = static_cast<uint8_t *>(mapping);
+
+    // Every word is known zero until it is handed out and released
+    zeroBits.assign((sizeInWords + 63) / 64, ~0ULL);
 
     // Build the big hole
     holes.push_back(Hole { 0, sizeInWords });
+    holesReset();
+    publishSummary();
+
+    // No blocks start anywhere yet
+    blockStarts.assign((sizeInWords + 63) / 64, 0);
+    blockSizes.assign(sizeInWords, 0);
+    blockTags.assign(sizeInWords, 0);
+    liveBlocks = 0;
 
     // Save the size in words for later use
     this->sizeInWords = sizeInWords;
+    capacityInWords = sizeInWords;
+
+    // No owner until a thread allocates (or calls setOwnerThread)
+    ownerThread = std::thread::id();
 }
 
 void MemoryManager::shutdown()
 {
-    // Deallocate the memory block created by the initialize function
-    delete[] memoryBlock;
+    // Flush and close any trace being recorded
+    stopRecording();
+
+    discardQueued();
+
+    if (sharedHeader)
+    {
+        // The memory block lives in the shared segment: unmap it, and remove the name if this process created it
+        munmap(sharedHeader, sharedBytes);
+        if (sharedCreator) { shm_unlink(sharedName.c_str()); }
+
+        sharedHeader = nullptr;
+        sharedBytes = 0;
+        sharedName = "";
+        sharedCreator = false;
+        sharedDepth = 0;
+    }
+    else
+    {
+        // Unmap the memory block created by the initialize function
+        if (memoryBlock) { munmap(memoryBlock, capacityInWords * wordSize); }
+    }
+    capacityInWords = 0;
 
     // Reset the memory block and holes
     memoryBlock = nullptr;
     holes.clear();
-    allocations.clear();
+    summaryFreeWords = 0;
+    summaryHoleCount = 0;
+    summaryLargestHole = 0;
+    summaryLargestStale = false;
+    summaryDirty = true;
+    publishSummary();
+    blockSizes.clear();
+    blockTags.clear();
+    liveBlocks = 0;
+    tagBytes.fill(0);
+    lineStraddlers = 0;
+    pageStraddlers = 0;
+    blockStarts.clear();
+    zeroBits.clear();
+
+    // Unmap the direct mappings
+    for (auto it = directMappings.begin(); it != directMappings.end(); ++it) { munmap(it->first, directMappedBytes(it->second.sizeInWords)); }
+    directMappings.clear();
+    directBytes = 0;
+
+    // Leave arena mode (its blocks went away with the memory block)
+    arenaMode = false;
+    arenaBase = 0;
+    arenaTop = 0;
+
+    // Leave the bitmap engine
+    bitmapEngine = false;
+    usedBits.clear();
+    fullBits.clear();
+    holesDirty = false;
+}
+
+void MemoryManager::reset(bool releasePages) { reinitialize(sizeInWords, releasePages); }
+
+void MemoryManager::reinitialize(size_t sizeInWords, bool releasePages)
+{
+    // Shared heaps belong to every attached process
+    if (sharedHeader) { return; }
+
+    // Without a block big enough to reuse, start over, keeping the modes a reset within capacity would keep
+    if (!memoryBlock || (sizeInWords == 0) || (sizeInWords > capacityInWords))
+    {
+        bool wasArena = arenaMode;
+        bool wasBitmap = bitmapEngine;
+
+        initialize(sizeInWords);
+
+        if (wasArena) { setArenaMode(true); }
+        if (wasBitmap) { setBitmapEngine(true); }
+        return;
+    }
+
+    // The recording would no longer replay, and queued work refers to the old blocks
+    stopRecording();
+    discardQueued();
+
+    // Every block goes away (only the words where blocks start need their sizes cleared)
+    for (size_t i = 0; i < blockStarts.size(); i++)
+    {
+        for (uint64_t bits = blockStarts[i]; bits != 0; bits &= bits - 1) { blockSizes[(i * 64) + __builtin_ctzll(bits)] = 0; }
+    }
+    liveBlocks = 0;
+    tagBytes.fill(0);
+    lineStraddlers = 0;
+    pageStraddlers = 0;
+    for (auto it = directMappings.begin(); it != directMappings.end(); ++it) { munmap(it->first, directMappedBytes(it->second.sizeInWords)); }
+    directMappings.clear();
+    directBytes = 0;
+
+    // One big hole again; the vector keeps its capacity
+    this->sizeInWords = sizeInWords;
+    holes.clear();
+    holes.push_back(Hole { 0, sizeInWords });
+    holesReset();
+    publishSummary();
+
+    // The per-word bitmaps are a sixty-fourth of the heap's words
+    std::fill(blockStarts.begin(), blockStarts.end(), 0);
+    if (releasePages)
+    {
+        // Hand the pages back; they read as zero the next time they are touched
+        madvise(memoryBlock, capacityInWords * wordSize, MADV_DONTNEED);
+        std::fill(zeroBits.begin(), zeroBits.end(), ~0ULL);
+    }
+    else
+    {
+        // Contents are left as they were, so nothing is known zero
+        std::fill(zeroBits.begin(), zeroBits.end(), 0);
+    }
+
+    // An arena now spans the whole block
+    arenaBase = 0;
+    arenaTop = 0;
+
+    // The bitmap engine starts over with every word free (the padding past the end stays used)
+    if (bitmapEngine)
+    {
+        size_t bitWords = (sizeInWords + 63) / 64;
+        usedBits.assign(bitWords, ~0ULL);
+        fullBits.assign((bitWords + 63) / 64, 0);
+        summaryFreeWords = 0;
+        summaryHoleCount = 0;
+        summaryLargestHole = 0;
+        markWords(0, sizeInWords, false);
+        holesDirty = false;
+    }
+    publishSummary();
+
+    // The next thread to allocate owns the heap
+    ownerThread = std::thread::id();
+
+    wakeWaiters();
+}
+
+void MemoryManager::discardQueued()
+{
+    // Queued async requests can no longer be served
+    for (auto it = pendingAllocations.begin(); it != pendingAllocations.end(); ++it) { it->second.promise.set_value(nullptr); }
+    pendingAllocations.clear();
+
+    // Queued frees refer to blocks being released, so just discard them
+    RemoteFree *pending = remoteFrees.exchange(nullptr, std::memory_order_acquire);
+    while (pending)
+    {
+        RemoteFree *next = pending->next;
+        delete pending;
+        pending = next;
+    }
 }
 
 void *MemoryManager::getList()
 {
+    SharedLock guard(this);
+
+    // The bitmap engine rebuilds the holes lazily
+    syncHoles();
+
     // Count holes
     int holeCount = holes.size();
 
@@ -52,277 +373,2734 @@ void *MemoryManager::getList()
     // Set the first element to the hole count
     holeList[0] = holeCount;
 
-    // Loop through and grab the offset and size of each hole
-    int index = 1;
-    for (auto it = holes.begin(); it != holes.end(); ++it)
+    // Loop through and grab the offset and size of each hole
+    int index = 1;
+    for (auto it = holes.begin(); it != holes.end(); ++it)
+    {
+        holeList[index] = it->offset;
+        index++;
+        holeList[index] = it->size;
+        index++;
+    }
+
+    return holeList;
+}
+
+size_t MemoryManager::getList(uint16_t *buffer, size_t capacity, size_t startWord, size_t rangeInWords)
+{
+    SharedLock guard(this);
+    syncHoles();
+
+    // Clip the range to the memory block
+    if (startWord > sizeInWords) { startWord = sizeInWords; }
+    size_t endWord = (rangeInWords > (sizeInWords - startWord)) ? sizeInWords : (startWord + rangeInWords);
+
+    // First hole that ends inside the range (holes are sorted by offset)
+    auto first = std::partition_point(holes.begin(), holes.end(),
+        [startWord](const Hole &hole) { return (hole.offset + hole.size) <= startWord; });
+
+    // Count the holes overlapping the range
+    auto last = first;
+    while ((last != holes.end()) && (last->offset < endWord)) { ++last; }
+    size_t holeCount = last - first;
+
+    // The caller gets the required length (count plus offset/size pairs) even if the buffer is too small
+    size_t required = 1 + (holeCount * 2);
+    if (!buffer || (capacity < required)) { return required; }
+
+    buffer[0] = holeCount;
+
+    // Copy the holes, trimmed to the range
+    size_t index = 1;
+    for (auto it = first; it != last; ++it)
+    {
+        size_t offset = std::max(it->offset, startWord);
+        size_t end = std::min(it->offset + it->size, endWord);
+
+        buffer[index] = offset;
+        index++;
+        buffer[index] = end - offset;
+        index++;
+    }
+
+    return required;
+}
+
+void *MemoryManager::allocate(size_t sizeInBytes) { return allocate(sizeInBytes, 0); }
+
+void *MemoryManager::allocate(size_t sizeInBytes, uint8_t tag) { return allocateBlock(sizeInBytes, tag, Lifetime::Medium); }
+
+void *MemoryManager::allocate(size_t sizeInBytes, Lifetime lifetime) { return allocateBlock(sizeInBytes, 0, lifetime); }
+
+void *MemoryManager::allocateBlock(size_t sizeInBytes, uint8_t tag, Lifetime lifetime)
+{
+    if (sizeInBytes == 0) { return nullptr; }
+    if (!memoryBlock) { return nullptr; }
+
+    // Coalesce any blocks freed by other threads since the last allocation
+    drainRemoteFrees();
+
+    // Very large requests get their own mapping instead of carving up the memory block (still within the usage limits)
+    if ((directMapThreshold != 0) && (sizeInBytes >= directMapThreshold) && !sharedHeader)
+    {
+        if (((softLimit != 0) || (hardLimit != 0)) && !enforceUsageLimits(directMappedBytes(toWords(sizeInBytes)))) { return nullptr; }
+        return allocateDirect(sizeInBytes, tag);
+    }
+
+    // Calculate the size in words needed for the allocation
+    size_t sizeInWords = toWords(sizeInBytes);
+    
+    // Ensure the size in words does not exceed memory size
+    if (sizeInWords > this->sizeInWords) { return nullptr; }
+
+    SharedLock guard(this);
+
+    // Ask for memory back before crossing a usage limit
+    if (((softLimit != 0) || (hardLimit != 0)) && !enforceUsageLimits(sizeInWords * wordSize)) { return nullptr; }
+
+    // Arena mode bypasses the allocator and the block tables
+    if (arenaMode)
+    {
+        void *address = bumpAllocate(sizeInWords);
+        publishSummary();
+        return address;
+    }
+
+    // The adaptive selector charges each policy for the holes it actually reads
+    size_t holesScanned = (adaptive && (lifetime == Lifetime::Medium)) ? adaptiveScanCount(sizeInWords) : 0;
+
+#ifdef MEMORY_MANAGER_TRACE
+    bool traced = tracing.load(std::memory_order_relaxed);
+    uint64_t traceStart = traced ? traceNow() : 0;
+#endif
+
+    // Place the block in a hole
+    uint8_t *allocationAddress = static_cast<uint8_t *>(placeBlock(sizeInWords, lifetime));
+    publishSummary();
+
+    // No hole fits: let the pressure callbacks free what they can, then retry once
+    if (!allocationAddress && relieveShortfall(sizeInWords))
+    {
+        allocationAddress = static_cast<uint8_t *>(placeBlock(sizeInWords, lifetime));
+        publishSummary();
+    }
+
+    // Feed the adaptive selector (hinted blocks bypass the allocator)
+    if (adaptive && (lifetime == Lifetime::Medium)) { adaptiveRecord(sizeInWords, allocationAddress != nullptr, holesScanned); }
+
+#ifdef MEMORY_MANAGER_TRACE
+    if (traced)
+    {
+        size_t traceOffset = allocationAddress ? ((allocationAddress - memoryBlock) / wordSize) : UINT32_MAX;
+        recordTrace(TraceOp::Allocate, sizeInWords, traceOffset, traceStart, holesScanned);
+    }
+#endif
+
+    if (recorder)
+    {
+        if (allocationAddress) { recordOp(RecordOp::Allocate, sizeInWords, (allocationAddress - memoryBlock) / wordSize); }
+        else { recordOp(RecordOp::FailedAllocate, sizeInWords, 0); }
+    }
+
+    if (!allocationAddress) { return nullptr; }
+
+    recordBlock(allocationAddress, sizeInWords, tag);
+
+    // Return a pointer to the newly allocated memory
+    return allocationAddress;
+}
+
+void *MemoryManager::allocateAligned(size_t sizeInBytes, size_t alignment)
+{
+    // Alignment must be a power of two
+    if ((alignment == 0) || ((alignment & (alignment - 1)) != 0)) { return nullptr; }
+
+    // Every word already satisfies small alignments
+    if (alignment <= naturalAlignment()) { return allocate(sizeInBytes); }
+
+    if (sizeInBytes == 0) { return nullptr; }
+    if (!memoryBlock) { return nullptr; }
+    if (arenaMode) { return nullptr; }
+
+    drainRemoteFrees();
+
+    size_t sizeInWords = toWords(sizeInBytes);
+    if (sizeInWords > this->sizeInWords) { return nullptr; }
+
+    SharedLock guard(this);
+
+    if (((softLimit != 0) || (hardLimit != 0)) && !enforceUsageLimits(sizeInWords * wordSize)) { return nullptr; }
+
+    uint8_t *allocationAddress = static_cast<uint8_t *>(placeAligned(sizeInWords, alignment));
+    publishSummary();
+
+    if (!allocationAddress && relieveShortfall(sizeInWords))
+    {
+        allocationAddress = static_cast<uint8_t *>(placeAligned(sizeInWords, alignment));
+        publishSummary();
+    }
+
+    // Aligned blocks are freed through free(), which records the release, so record the placement too
+    if (recorder)
+    {
+        if (allocationAddress) { recordOp(RecordOp::Allocate, sizeInWords, (allocationAddress - memoryBlock) / wordSize); }
+        else { recordOp(RecordOp::FailedAllocate, sizeInWords, 0); }
+    }
+
+    if (!allocationAddress) { return nullptr; }
+
+    recordBlock(allocationAddress, sizeInWords);
+
+    return allocationAddress;
+}
+
+void *MemoryManager::allocateNear(void *hint, size_t sizeInBytes)
+{
+    // Without a usable hint this is a plain allocation
+    bool inBlock = memoryBlock && (hint >= memoryBlock) && (hint < memoryBlock + (sizeInWords * wordSize));
+    if (!inBlock || arenaMode) { return allocate(sizeInBytes); }
+    if ((directMapThreshold != 0) && (sizeInBytes >= directMapThreshold) && !sharedHeader) { return allocate(sizeInBytes); }
+    if (sizeInBytes == 0) { return nullptr; }
+
+    drainRemoteFrees();
+
+    size_t sizeInWords = toWords(sizeInBytes);
+    if (sizeInWords > this->sizeInWords) { return nullptr; }
+
+    SharedLock guard(this);
+
+    if (((softLimit != 0) || (hardLimit != 0)) && !enforceUsageLimits(sizeInWords * wordSize)) { return nullptr; }
+
+    size_t hintInWords = (static_cast<uint8_t *>(hint) - memoryBlock) / wordSize;
+    uint8_t *allocationAddress = static_cast<uint8_t *>(placeNear(sizeInWords, hintInWords));
+
+    // Nothing close enough: fall back to the allocator, then to the pressure callbacks
+    if (!allocationAddress) { allocationAddress = static_cast<uint8_t *>(placeBlock(sizeInWords)); }
+    if (!allocationAddress && relieveShortfall(sizeInWords)) { allocationAddress = static_cast<uint8_t *>(placeNear(sizeInWords, hintInWords)); }
+    if (!allocationAddress) { allocationAddress = static_cast<uint8_t *>(placeBlock(sizeInWords)); }
+    publishSummary();
+
+    if (recorder)
+    {
+        if (allocationAddress) { recordOp(RecordOp::Allocate, sizeInWords, (allocationAddress - memoryBlock) / wordSize); }
+        else { recordOp(RecordOp::FailedAllocate, sizeInWords, 0); }
+    }
+
+    if (!allocationAddress) { return nullptr; }
+
+    recordBlock(allocationAddress, sizeInWords);
+
+    return allocationAddress;
+}
+
+void *MemoryManager::placeNear(size_t sizeInWords, size_t hintInWords)
+{
+    syncHoles();
+
+    // Holes are sorted by offset: start at the first hole above the hint and walk outward both ways
+    auto above = std::lower_bound(holes.begin(), holes.end(), hintInWords,
+        [](const Hole &hole, size_t offset) { return hole.offset < offset; });
+    auto below = above;
+
+    size_t bestDistance = SIZE_MAX;
+    size_t bestOffset = 0;
+
+    for (size_t step = 0; step < NearSearchHoles; step++)
+    {
+        // Holes above the hint give up their bottom
+        if (above != holes.end())
+        {
+            if ((above->size >= sizeInWords) && ((above->offset - hintInWords) < bestDistance))
+            {
+                bestDistance = above->offset - hintInWords;
+                bestOffset = above->offset;
+            }
+            ++above;
+        }
+
+        // Holes below the hint give up their top
+        if (below != holes.begin())
+        {
+            --below;
+            size_t holeEnd = below->offset + below->size;
+            size_t distance = (holeEnd > hintInWords) ? 0 : (hintInWords - holeEnd);
+            if ((below->size >= sizeInWords) && (distance < bestDistance))
+            {
+                // A hole containing the hint is carved as close to the hint as the block allows
+                bestDistance = distance;
+                bestOffset = std::max(below->offset, std::min(hintInWords, holeEnd - sizeInWords));
+            }
+        }
+
+        // Every further hole is farther away than the best so far
+        bool aboveFarther = (above == holes.end()) || ((above->offset - hintInWords) >= bestDistance);
+        bool belowFarther = (below == holes.begin()) || ((hintInWords - (std::prev(below)->offset + std::prev(below)->size)) >= bestDistance);
+        if (aboveFarther && belowFarther) { break; }
+    }
+
+    if (bestDistance == SIZE_MAX) { return nullptr; }
+
+    carveRange(bestOffset, sizeInWords);
+    return (memoryBlock + (bestOffset * wordSize));
+}
+
+// Zeroes a range, bypassing the cache with streaming stores when it is large
+static void clearBytes(uint8_t *start, size_t length, size_t streamThreshold)
+{
+#ifdef __SSE2__
+    if (length >= streamThreshold)
+    {
+        // Plain stores up to a 16-byte boundary, then 16 bytes per streaming store
+        size_t head = (16 - (reinterpret_cast<uintptr_t>(start) % 16)) % 16;
+        memset(start, 0, head);
+
+        size_t body = (length - head) & ~static_cast<size_t>(15);
+        __m128i zero = _mm_setzero_si128();
+        for (size_t i = 0; i < body; i += 16) { _mm_stream_si128(reinterpret_cast<__m128i *>(start + head + i), zero); }
+        _mm_sfence();
+
+        memset(start + head + body, 0, length - head - body);
+        return;
+    }
+#else
+    (void)streamThreshold;
+#endif
+
+    memset(start, 0, length);
+}
+
+void *MemoryManager::allocateZeroed(size_t sizeInBytes)
+{
+    uint8_t *address = static_cast<uint8_t *>(allocate(sizeInBytes));
+    if (!address) { return nullptr; }
+
+    // Direct mappings are fresh pages
+    bool inBlock = (address >= memoryBlock) && (address < memoryBlock + (sizeInWords * wordSize));
+    if (!inBlock) { return address; }
+
+    size_t offsetInWords = (address - memoryBlock) / wordSize;
+    size_t endWord = offsetInWords + toWords(sizeInBytes);
+
+    // No zero tracking (shared heap): clear it all
+    if (zeroBits.empty())
+    {
+        clearBytes(address, sizeInBytes, StreamZeroBytes);
+        return address;
+    }
+
+    // Clear only the runs of words not known to be zero
+    size_t word = offsetInWords;
+    while (word < endWord)
+    {
+        // Skip known-zero words, 64 at a time where possible
+        if ((word % 64 == 0) && (zeroBits[word / 64] == ~0ULL)) { word += 64; continue; }
+        if ((zeroBits[word / 64] >> (word % 64)) & 1) { word++; continue; }
+
+        // Find the end of the dirty run
+        size_t runStart = word;
+        while ((word < endWord) && !((zeroBits[word / 64] >> (word % 64)) & 1))
+        {
+            if ((word % 64 == 0) && (zeroBits[word / 64] == 0)) { word += 64; }
+            else { word++; }
+        }
+        if (word > endWord) { word = endWord; }
+
+        clearBytes(memoryBlock + (runStart * wordSize), (word - runStart) * wordSize, StreamZeroBytes);
+    }
+
+    return address;
+}
+
+void MemoryManager::setReleasePagesThreshold(size_t sizeInBytes) { releasePagesThreshold = sizeInBytes; }
+
+void MemoryManager::markDirty(size_t offsetInWords, size_t sizeInWords)
+{
+    if (zeroBits.empty() || (sizeInWords == 0)) { return; }
+
+    // The block was handed out, so its words may hold anything
+    size_t first = offsetInWords / 64;
+    size_t last = (offsetInWords + sizeInWords - 1) / 64;
+    for (size_t i = first; i <= last; i++)
+    {
+        size_t low = (i == first) ? (offsetInWords % 64) : 0;
+        size_t high = (i == last) ? ((offsetInWords + sizeInWords - 1) % 64) : 63;
+        zeroBits[i] &= ~((~0ULL >> (63 - high)) & (~0ULL << low));
+    }
+
+    // Large frees give their whole pages back when asked to; the OS hands them out zeroed next time they are touched
+    if ((releasePagesThreshold == 0) || ((sizeInWords * wordSize) < releasePagesThreshold)) { return; }
+
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    size_t startByte = ((offsetInWords * wordSize) + pageSize - 1) / pageSize * pageSize;
+    size_t endByte = ((offsetInWords + sizeInWords) * wordSize) / pageSize * pageSize;
+    if (endByte <= startByte) { return; }
+    if (madvise(memoryBlock + startByte, endByte - startByte, MADV_DONTNEED) != 0) { return; }
+
+    // Only words lying wholly inside the released pages are known zero
+    size_t firstWord = (startByte + wordSize - 1) / wordSize;
+    size_t endWord = endByte / wordSize;
+    for (size_t word = firstWord; word < endWord; word++) { zeroBits[word / 64] |= (1ULL << (word % 64)); }
+}
+
+void MemoryManager::free(void *address)
+{
+    if (!memoryBlock) { return; }
+    if (!address) { return; }
+
+    // Other threads hand the block to the owner instead of touching the holes (a shared heap is locked instead).
+    // Addresses outside the block are queued too: they may be direct mappings, which the owner looks up.
+    if (isRemoteThread())
+    {
+        pushRemoteFree(address, 0);
+        return;
+    }
+
+    freeLocal(address);
+}
+
+void MemoryManager::setOwnerThread() { ownerThread = std::this_thread::get_id(); }
+
+bool MemoryManager::isRemoteThread()
+{
+    if (sharedHeader) { return false; }
+
+    // Without an owner yet, every thread frees directly
+    std::thread::id owner = ownerThread.load(std::memory_order_relaxed);
+    return (owner != std::thread::id()) && (owner != std::this_thread::get_id());
+}
+
+void MemoryManager::freeLocal(void *address)
+{
+    bool inBlock = (address >= memoryBlock) && (address < memoryBlock + (sizeInWords * wordSize));
+
+    // Addresses outside the memory block can only be direct mappings
+    if (!inBlock)
+    {
+        freeDirect(address);
+        return;
+    }
+
+    SharedLock guard(this);
+    
+    // Ensure the address is allocated
+    size_t sizeInWords = forgetBlock((uint8_t*)address);
+    if (sizeInWords == 0) { return; } // Address not found
+
+    // Determine the offset in bytes (difference between the address and the memory block)
+    size_t offsetInBytes = ((uint8_t *)address - memoryBlock);
+
+    // Convert the offset in bytes to an offset in words
+    size_t offsetInWords = (offsetInBytes / wordSize);
+
+    releaseBlock(offsetInWords, sizeInWords);
+}
+
+void MemoryManager::free(void *address, size_t sizeInBytes)
+{
+    if (!memoryBlock) { return; }
+    if (sizeInBytes == 0) { return; }
+
+    bool inBlock = (address >= memoryBlock) && (address < memoryBlock + (sizeInWords * wordSize));
+
+    // Remote and direct-mapped frees take the unsized path
+    if (isRemoteThread() || !inBlock)
+    {
+        free(address);
+        return;
+    }
+
+    SharedLock guard(this);
+
+    // Constant-time ownership check instead of a map lookup
+    size_t offsetInBytes = (static_cast<uint8_t *>(address) - memoryBlock);
+    if ((offsetInBytes % wordSize) != 0) { return; }
+    size_t offsetInWords = offsetInBytes / wordSize;
+    if (!isBlockStart(offsetInWords)) { return; }
+
+    size_t sizeInWords = toWords(sizeInBytes);
+
+    // Debug builds check the caller's size against the recorded one
+    assert((sharedHeader ? sharedBlockSizes()[offsetInWords] : blockSizes[offsetInWords]) == sizeInWords);
+
+    // Clearing the table entry is an index, not a search; the caller's size is what gets released
+    if (forgetBlock(static_cast<uint8_t *>(address)) == 0) { return; }
+
+    releaseBlock(offsetInWords, sizeInWords);
+}
+
+bool MemoryManager::owns(void *address)
+{
+    if (!memoryBlock) { return false; }
+
+    bool inBlock = (address >= memoryBlock) && (address < memoryBlock + (sizeInWords * wordSize));
+    if (!inBlock) { return directMappings.count(static_cast<uint8_t *>(address)) != 0; }
+
+    SharedLock guard(this);
+
+    // Only the first word of a live block counts
+    size_t offsetInBytes = (static_cast<uint8_t *>(address) - memoryBlock);
+    if ((offsetInBytes % wordSize) != 0) { return false; }
+
+    return isBlockStart(offsetInBytes / wordSize);
+}
+
+void *MemoryManager::allocateWait(size_t sizeInBytes, std::chrono::milliseconds timeout)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    while (true)
+    {
+        // allocate drains any queued frees first
+        void *address = allocate(sizeInBytes);
+        if (address) { return address; }
+
+        // Requests that can never fit are not worth waiting for
+        if (!memoryBlock || (sizeInBytes == 0)) { return nullptr; }
+        if ((toWords(sizeInBytes) > sizeInWords) && ((directMapThreshold == 0) || (sizeInBytes < directMapThreshold))) { return nullptr; }
+
+        // Sleep until another thread queues a free or a release leaves a big enough hole
+        // (another process's free on a shared heap cannot signal us, so poll)
+        size_t neededWords = toWords(sizeInBytes);
+        waiters++;
+        bool signalled;
+        {
+            std::unique_lock<std::mutex> lock(waitMutex);
+            auto waiting = waitingWords.insert(neededWords);
+            auto wakeAt = sharedHeader ? std::min(deadline, std::chrono::steady_clock::now() + std::chrono::milliseconds(1)) : deadline;
+            signalled = freeSignal.wait_until(lock, wakeAt, [this, neededWords]() { return (remoteFrees.load() != nullptr) || (getSummary().largestHole >= neededWords); });
+            waitingWords.erase(waiting);
+        }
+        waiters--;
+
+        if (!signalled && (std::chrono::steady_clock::now() >= deadline)) { return allocate(sizeInBytes); }
+    }
+}
+
+std::future<void *> MemoryManager::allocateAsync(size_t sizeInBytes, uint8_t tag)
+{
+    std::promise<void *> promise;
+    std::future<void *> result = promise.get_future();
+
+    // Serve it now if it fits
+    void *address = allocate(sizeInBytes, tag);
+    size_t sizeInWords = toWords(sizeInBytes);
+    bool direct = (directMapThreshold != 0) && (sizeInBytes >= directMapThreshold);
+    if (address || !memoryBlock || (sizeInBytes == 0) || direct || (sizeInWords > this->sizeInWords))
+    {
+        promise.set_value(address);
+        return result;
+    }
+
+    // Otherwise queue it until a free makes room
+    pendingAllocations.emplace(sizeInWords, PendingAllocation { sizeInBytes, tag, std::move(promise) });
+
+    return result;
+}
+
+void MemoryManager::wakeWaiters()
+{
+    if (waiters.load() == 0) { return; }
+
+    // Only worth waking anyone once the smallest waiting request fits (each waiter rechecks its own size)
+    std::lock_guard<std::mutex> lock(waitMutex);
+    if (!waitingWords.empty() && (*waitingWords.begin() <= getSummary().largestHole)) { freeSignal.notify_all(); }
+}
+
+void MemoryManager::servePending(size_t offsetInWords)
+{
+    // Every release path ends here, so blocked waiters are woken from here too
+    wakeWaiters();
+
+    if (pendingAllocations.empty() || servingPending) { return; }
+
+    // Skip the retry unless the freed block coalesced into a hole at least as big as the smallest request
+    if ((offsetInWords != SIZE_MAX) && !bitmapEngine)
+    {
+        auto hole = std::partition_point(holes.begin(), holes.end(),
+            [offsetInWords](const Hole &hole) { return (hole.offset + hole.size) <= offsetInWords; });
+        if ((hole == holes.end()) || (hole->offset > offsetInWords)) { return; }
+        if (hole->size < pendingAllocations.rbegin()->first) { return; }
+    }
+
+    servingPending = true;
+
+    // Largest first, so big requests are not starved by a stream of small ones
+    for (auto it = pendingAllocations.begin(); it != pendingAllocations.end();)
+    {
+        void *address = allocate(it->second.sizeInBytes, it->second.tag);
+        if (!address)
+        {
+            ++it;
+            continue;
+        }
+
+        it->second.promise.set_value(address);
+        it = pendingAllocations.erase(it);
+    }
+
+    servingPending = false;
+}
+
+void MemoryManager::releaseBlock(size_t offsetInWords, size_t sizeInWords)
+{
+#ifdef MEMORY_MANAGER_TRACE
+    bool traced = tracing.load(std::memory_order_relaxed);
+    uint64_t traceStart = traced ? traceNow() : 0;
+#endif
+
+    if (recorder) { recordOp(RecordOp::Free, sizeInWords, offsetInWords); }
+
+    // Perform hole updating
+    size_t holesScanned = releaseRange(offsetInWords, sizeInWords);
+    (void)holesScanned;
+    publishSummary();
+
+#ifdef MEMORY_MANAGER_TRACE
+    if (traced)
+    {
+        traceSearchNanos = 0;
+        traceUpdateNanos = static_cast<uint32_t>(traceNow() - traceStart);
+        recordTrace(TraceOp::Free, sizeInWords, offsetInWords, traceStart, holesScanned);
+    }
+#endif
+
+    // The coalesced hole may now fit a queued request
+    servePending(offsetInWords);
+}
+
+void MemoryManager::setAllocator(std::function<int(int, void *)> allocator)
+{
+    // An explicit choice turns adaptive selection off
+    adaptive = false;
+    policy = nullptr;
+    this->allocator = allocator;
+}
+
+void MemoryManager::setAllocatorPolicy(AllocatorPolicy *policy)
+{
+    SharedLock guard(this);
+    syncHoles();
+
+    // The policy takes over placement, starting from the current holes
+    adaptive = false;
+    this->policy = policy;
+    if (policy) { policy->onHolesReset(holes); }
+}
+
+int MemoryManager::dumpMemoryMap(char *filename)
+{
+    // Open/create the file for writing
+    int openedFile = open(filename, O_TRUNC | O_CREAT | O_WRONLY, 0644);
+    if (openedFile == -1) { return -1; } 
+
+    // Fetch the hole list
+    void *holeList = getList();
+
+    // Ensure the holeList is valid
+    if (!holeList) 
+    { 
+        close(openedFile);
+        return -1; 
+    }
+
+    // Fetch the hole count
+    size_t holeCount = ((uint16_t *)holeList)[0];
+    
+    std::vector<std::string> textVector;
+    for (size_t i = 1; i <= holeCount * 2; i++)
+    {
+        if (i % 2 != 0)
+        {
+            // i is odd, push offset
+            textVector.push_back("[" + std::to_string(((uint16_t *)holeList)[i]) + ", ");
+        }
+        else
+        {
+            // i is even, push size
+            textVector.push_back(std::to_string(((uint16_t *)holeList)[i]) + "]");
+
+            if (i != holeCount * 2)
+            {
+                // Add " - " if it's not the last element
+                textVector.push_back(" - ");
+            }
+        }
+    }
+
+    delete[] static_cast<uint16_t*>(holeList);
+
+    // Direct mappings follow the holes, one per line
+    for (auto it = directMappings.begin(); it != directMappings.end(); ++it)
+    {
+        char address[32];
+        snprintf(address, sizeof(address), "%p", static_cast<void *>(it->first));
+        textVector.push_back("\ndirect [" + std::string(address) + ", " + std::to_string(it->second.sizeInWords) + "]");
+    }
+
+    // Write the text vector to the openedFile
+    for (auto text : textVector) { write(openedFile, text.c_str(), text.length());}
+
+    // Close the file
+    close(openedFile);
+
+    // Success
+    return 0;
+}
+
+void *MemoryManager::getBitmap()
+{
+    if (!memoryBlock) { return nullptr; }
+    if (sizeInWords == 0) { return nullptr; }
+    
+    // Determine the size (bytes) needed for the bitmap
+    size_t bitmapSize = (sizeInWords / 8);
+
+    // If there is a remainder, one more byte is required
+    if (sizeInWords % 8 != 0) { bitmapSize++; }
+
+    SharedLock guard(this);
+
+    if (bitmapEngine)
+    {
+        // The engine's own bitmap already has the right layout (bit i of byte j is word 8j + i)
+        uint8_t *engineBitmap = new uint8_t[bitmapSize + 2];
+        engineBitmap[0] = bitmapSize & 0xFF;
+        engineBitmap[1] = (bitmapSize >> 8) & 0xFF;
+
+        for (size_t i = 0; i < bitmapSize; i++) { engineBitmap[i + 2] = (usedBits[i / 8] >> ((i % 8) * 8)) & 0xFF; }
+
+        // Clear the padding bits past the end of memory
+        if (sizeInWords % 8 != 0) { engineBitmap[bitmapSize + 1] &= 0xFF >> (8 - (sizeInWords % 8)); }
+
+        return engineBitmap;
+    }
+
+    // Declare the bitmap
+    uint8_t *bitmap = new uint8_t[bitmapSize];
+    
+    // Initialize the bitmap to 0s (all holes)
+    memset(bitmap, 0, bitmapSize);
+    
+    // Create a buffer bitmap of all 1s
+    uint8_t *bufferBitmap = new uint8_t[bitmapSize]; 
+    memset(bufferBitmap, 0xFF, bitmapSize);
+    
+    // Modify the buffer bitmap with 0s where holes exist
+    // Iterate through each hole
+    for (auto it = holes.begin(); it != holes.end(); ++it) 
+    {
+        // Iterate through the length (size) of the current hole (it)
+        for (size_t i = 0; i < it->size; ++i) 
+        {
+            size_t bitIndex = (it->offset + i);
+            
+            // If bits exist beyond memory, ignore them
+            if (bitIndex >= sizeInWords) { continue; }
+            
+            size_t byteIndex = (bitIndex / 8);
+            size_t bitOffset = (bitIndex % 8);
+            
+            // Set the bit to 0 in the buffer bitmap
+            bufferBitmap[byteIndex] &= ~(1 << bitOffset);
+        }
+    }
+    
+    // Now copy the buffer bitmap to the final bitmap
+    memcpy(bitmap, bufferBitmap, bitmapSize);
+    
+    // Ensure the last byte is correct if sizeInWords had a remainder byte
+    if (sizeInWords % 8 != 0) 
+    {
+        size_t lastByteBits = sizeInWords % 8;
+        size_t lastByteIndex = bitmapSize - 1;
+        
+        // Create a mask with 1s for bits to keep
+        uint8_t mask = 0xFF >> (8 - lastByteBits);
+        
+        // Apply the mask to the last byte
+        bitmap[lastByteIndex] &= mask;
+    }
+    
+    delete[] bufferBitmap;
+    
+    // Create the final bitmap with size bytes
+    uint8_t *finalBitmap = new uint8_t[bitmapSize + 2];
+    
+    // Set the first two bytes (size bytes) in little-endian
+    finalBitmap[0] = bitmapSize & 0xFF;
+    finalBitmap[1] = (bitmapSize >> 8) & 0xFF;
+    
+    // Copy the bitmap data to final
+    for (size_t i = 0; i < bitmapSize; i++) { finalBitmap[i + 2] = bitmap[i]; }
+
+    delete[] bitmap;
+    
+    return finalBitmap;
+}
+
+size_t MemoryManager::getBitmap(uint8_t *buffer, size_t capacity, size_t startWord, size_t rangeInWords)
+{
+    // Clip the range to the memory block
+    if (startWord > sizeInWords) { startWord = sizeInWords; }
+    size_t endWord = (rangeInWords > (sizeInWords - startWord)) ? sizeInWords : (startWord + rangeInWords);
+    size_t rangeWords = endWord - startWord;
+
+    // Two size bytes followed by one bit per word of the range
+    size_t bitmapSize = (rangeWords + 7) / 8;
+    size_t required = bitmapSize + 2;
+    if (!buffer || (capacity < required)) { return required; }
+
+    SharedLock guard(this);
+
+    buffer[0] = bitmapSize & 0xFF;
+    buffer[1] = (bitmapSize >> 8) & 0xFF;
+    uint8_t *bitmap = buffer + 2;
+
+    if (bitmapEngine)
+    {
+        // Read the engine bitmap directly, shifting it so the range starts at bit 0
+        for (size_t i = 0; i < bitmapSize; i++)
+        {
+            uint8_t byte = 0;
+            for (size_t bit = 0; bit < 8; bit++)
+            {
+                size_t word = startWord + (i * 8) + bit;
+                if (word >= endWord) { break; }
+                if ((usedBits[word / 64] >> (word % 64)) & 1) { byte |= (1 << bit); }
+            }
+            bitmap[i] = byte;
+        }
+
+        return required;
+    }
+
+    fillBitmapRange(holes, bitmap, startWord, endWord);
+
+    // Clear the padding bits past the end of the range
+    if (rangeWords % 8 != 0) { bitmap[bitmapSize - 1] &= 0xFF >> (8 - (rangeWords % 8)); }
+
+    return required;
+}
+
+unsigned MemoryManager::getWordSize() { return wordSize; }
+
+void *MemoryManager::getMemoryStart() { return memoryBlock; }
+
+unsigned MemoryManager::getMemoryLimit() { return sizeInWords * wordSize; }
+
+void MemoryManager::setArenaMode(bool enabled)
+{
+    if (!memoryBlock) { return; }
+    if (enabled == arenaMode) { return; }
+    if (bitmapEngine) { return; } // The arena works on the hole list
+    if (sharedHeader) { return; } // Other processes could not see the arena top
+
+    if (!enabled)
+    {
+        // Leaving arena mode releases everything bumped since it was entered
+        resetAll();
+        arenaMode = false;
+        return;
+    }
+
+    // The arena grows through the tail hole (the hole that ends at the end of memory)
+    arenaBase = sizeInWords;
+    if (!holes.empty() && (holes.back().offset + holes.back().size) == sizeInWords)
+    {
+        arenaBase = holes.back().offset;
+    }
+
+    arenaTop = arenaBase;
+    arenaMode = true;
+}
+
+size_t MemoryManager::mark() { return arenaTop; }
+
+void MemoryManager::resetTo(size_t marker)
+{
+    if (!arenaMode) { return; }
+
+    // Markers must lie inside the live part of the arena
+    if ((marker < arenaBase) || (marker > arenaTop)) { return; }
+    if (marker == arenaTop) { return; }
+
+    // Everything bumped above the marker was handed out
+    markDirty(marker, arenaTop - marker);
+
+    // Drop the tail hole above the marker, it is rebuilt below
+    if (!holes.empty() && (holes.back().offset + holes.back().size) == sizeInWords && holes.back().offset >= marker)
+    {
+        holeRemoved(holes.back());
+        holes.pop_back();
+    }
+
+    // Grow a hole that ends exactly at the marker, or add a new tail hole
+    if (!holes.empty() && (holes.back().offset + holes.back().size) == marker)
+    {
+        Hole before = holes.back();
+        holes.back().size = sizeInWords - holes.back().offset;
+        holeResized(before, holes.back());
+    }
+    else
+    {
+        holes.push_back(Hole { marker, sizeInWords - marker });
+        holeCreated(holes.back());
+    }
+
+    arenaTop = marker;
+    publishSummary();
+
+    servePending(marker);
+}
+
+void MemoryManager::resetAll() { resetTo(arenaBase); }
+
+void *MemoryManager::bumpAllocate(size_t sizeInWords)
+{
+    // Ensure the block fits between the arena top and the end of memory
+    if (sizeInWords > (this->sizeInWords - arenaTop)) { return nullptr; }
+
+    // The tail hole always covers the space above the arena top
+    if (holes.empty()) { return nullptr; }
+    Hole &tail = holes.back();
+    if ((tail.offset + tail.size) != this->sizeInWords || tail.offset > arenaTop) { return nullptr; }
+
+    Hole before = tail;
+
+    if (tail.offset == arenaTop)
+    {
+        // Common case: bump the start of the tail hole
+        tail.offset += sizeInWords;
+        tail.size -= sizeInWords;
+
+        // Leave no empty hole
+        if (tail.size == 0)
+        {
+            holes.pop_back();
+            holeRemoved(before);
+        }
+        else { holeResized(before, tail); }
+    }
+    else
+    {
+        // A free below the empty arena coalesced into the tail hole: split it at the arena top
+        tail.size = arenaTop - tail.offset;
+        holeResized(before, tail);
+
+        size_t remaining = this->sizeInWords - (arenaTop + sizeInWords);
+        if (remaining > 0)
+        {
+            holes.push_back(Hole { arenaTop + sizeInWords, remaining });
+            holeCreated(holes.back());
+        }
+    }
+
+    // Bump the arena top
+    uint8_t *address = memoryBlock + (arenaTop * wordSize);
+    arenaTop += sizeInWords;
+
+    return address;
+}
+
+void MemoryManager::recordBlock(uint8_t *address, size_t sizeInWords, uint8_t tag)
+{
+    if (sharedHeader)
+    {
+        // Shared heaps keep the size next to the memory, indexed by word offset
+        sharedBlockSizes()[(address - memoryBlock) / wordSize] = sizeInWords;
+        return;
+    }
+
+    // Size and tag live in per-word tables indexed by the block's first word
+    size_t offsetInWords = (address - memoryBlock) / wordSize;
+    blockSizes[offsetInWords] = sizeInWords;
+    blockTags[offsetInWords] = tag;
+    liveBlocks++;
+    tagBytes[tag] += sizeInWords * wordSize;
+    countStraddles(address, sizeInWords, true);
+    setBlockStart(offsetInWords, true);
+}
+
+size_t MemoryManager::forgetBlock(uint8_t *address)
+{
+    if (sharedHeader)
+    {
+        if ((address - memoryBlock) % wordSize != 0) { return 0; }
+
+        uint32_t &size = sharedBlockSizes()[(address - memoryBlock) / wordSize];
+        size_t sizeInWords = size;
+        size = 0;
+
+        return sizeInWords;
+    }
+
+    // Look for address
+    if ((address - memoryBlock) % wordSize != 0) { return 0; }
+    size_t offsetInWords = (address - memoryBlock) / wordSize;
+    size_t sizeInWords = blockSizes[offsetInWords];
+    if (sizeInWords == 0) { return 0; }
+    tagBytes[blockTags[offsetInWords]] -= sizeInWords * wordSize;
+    countStraddles(address, sizeInWords, false);
+
+    blockSizes[offsetInWords] = 0;
+    liveBlocks--;
+    setBlockStart(offsetInWords, false);
+
+    return sizeInWords;
+}
+
+void MemoryManager::setBlockStart(size_t offsetInWords, bool started)
+{
+    // Shared heaps answer from their block-size table instead
+    if (sharedHeader) { return; }
+
+    uint64_t bit = uint64_t(1) << (offsetInWords % 64);
+    if (started) { blockStarts[offsetInWords / 64] |= bit; }
+    else { blockStarts[offsetInWords / 64] &= ~bit; }
+}
+
+bool MemoryManager::isBlockStart(size_t offsetInWords)
+{
+    if (offsetInWords >= sizeInWords) { return false; }
+    if (sharedHeader) { return sharedBlockSizes()[offsetInWords] != 0; }
+
+    return (blockStarts[offsetInWords / 64] >> (offsetInWords % 64)) & 1;
+}
+
+size_t MemoryManager::toWords(size_t sizeInBytes)
+{
+    size_t sizeInWords = sizeInBytes / wordSize;
+    size_t remainder = sizeInBytes % wordSize; // Check for a remainder
+    if (remainder > 0) { sizeInWords++; } // If there is a remainder, bump up by one word
+
+    return sizeInWords;
+}
+
+size_t MemoryManager::naturalAlignment()
+{
+    // Largest power of two dividing the word size, capped by the alignment of the memory block itself
+    size_t alignment = wordSize & (~wordSize + 1);
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) { alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__; }
+
+    return alignment;
+}
+
+void *MemoryManager::placeBlock(size_t sizeInWords, Lifetime lifetime)
+{
+#ifdef MEMORY_MANAGER_TRACE
+    // Paths that return early must not leave the previous placement's timings behind
+    traceSearchNanos = 0;
+    traceUpdateNanos = 0;
+#endif
+
+    if (lifetime == Lifetime::Long)
+    {
+        // Lowest hole that fits, taken from its bottom, so long-lived blocks pack toward the start of memory
+        syncHoles();
+        for (auto it = holes.begin(); it != holes.end(); ++it)
+        {
+            if (it->size < sizeInWords) { continue; }
+
+            size_t offsetInWords = it->offset;
+            carveRange(offsetInWords, sizeInWords);
+            return (memoryBlock + (offsetInWords * wordSize));
+        }
+
+        return nullptr;
+    }
+
+    if (lifetime == Lifetime::Short)
+    {
+        // Highest hole that fits, taken from its top, so short-lived blocks stay toward the end of memory
+        syncHoles();
+        for (auto it = holes.rbegin(); it != holes.rend(); ++it)
+        {
+            if (it->size < sizeInWords) { continue; }
+
+            size_t offsetInWords = it->offset + it->size - sizeInWords;
+            carveRange(offsetInWords, sizeInWords);
+            return (memoryBlock + (offsetInWords * wordSize));
+        }
+
+        return nullptr;
+    }
+
+    if (bitmapEngine)
+    {
+        // First fit straight from the bitmap
+        long run = findFreeRun(sizeInWords);
+        if (run == -1) { return nullptr; }
+
+        markWords(run, sizeInWords, true);
+        return (memoryBlock + (run * wordSize));
+    }
+
+#ifdef MEMORY_MANAGER_TRACE
+    bool traced = tracing.load(std::memory_order_relaxed);
+    uint64_t searchStart = traced ? traceNow() : 0;
+#endif
+
+    long offset = -1;
+    if (policy)
+    {
+        // A policy keeps its own index, so no hole list is built
+        offset = policy->selectHole(sizeInWords);
+    }
+    else
+    {
+        // Fetch the hole list
+        void *holeList = getList();
+
+        // Call the allocator function to get the offset in words
+        offset = allocator(sizeInWords, holeList);
+
+        delete[] static_cast<uint16_t*>(holeList);
+    }
+
+#ifdef MEMORY_MANAGER_TRACE
+    uint64_t updateStart = traced ? traceNow() : 0;
+    if (traced) { traceSearchNanos = static_cast<uint32_t>(updateStart - searchStart); }
+#endif
+    
+    // Ensure allocation worked
+    if (offset == -1) { return nullptr; }
+
+    // Convert the offset in words to a size_t
+    size_t offsetInWords = static_cast<size_t>(offset);
+
+    // Small blocks may move further into the hole to stay inside one line or page
+    if ((boundaryThreshold != 0) && ((sizeInWords * wordSize) <= boundaryThreshold)) { offsetInWords = avoidBoundaries(offsetInWords, sizeInWords); }
+
+    // Update the fitting hole
+    bool carved = carveRange(offsetInWords, sizeInWords);
+
+#ifdef MEMORY_MANAGER_TRACE
+    if (traced) { traceUpdateNanos = static_cast<uint32_t>(traceNow() - updateStart); }
+#endif
+
+    if (!carved) { return nullptr; }
+
+    // Convert the offset in words to an address
+    return (memoryBlock + (offsetInWords * wordSize));
+}
+
+void *MemoryManager::placeAligned(size_t sizeInWords, size_t alignment)
+{
+    syncHoles();
+
+    // First fit over the holes, starting each candidate at its first aligned word
+    for (auto it = holes.begin(); it != holes.end(); ++it)
+    {
+        uintptr_t holeStart = reinterpret_cast<uintptr_t>(memoryBlock + (it->offset * wordSize));
+        uintptr_t alignedStart = (holeStart + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+
+        // The aligned address must also fall on a word boundary inside the hole
+        uintptr_t holeBytes = it->size * wordSize;
+        while (((alignedStart - holeStart) % wordSize != 0) && ((alignedStart - holeStart) < holeBytes)) { alignedStart += alignment; }
+
+        size_t skippedWords = (alignedStart - holeStart) / wordSize;
+        if ((skippedWords >= it->size) || ((it->size - skippedWords) < sizeInWords)) { continue; }
+
+        size_t offsetInWords = it->offset + skippedWords;
+        carveRange(offsetInWords, sizeInWords);
+
+        return (memoryBlock + (offsetInWords * wordSize));
+    }
+
+    // No hole can hold an aligned block
+    return nullptr;
+}
+
+bool MemoryManager::carveRange(size_t offsetInWords, size_t sizeInWords)
+{
+    if (bitmapEngine)
+    {
+        if (!wordsFree(offsetInWords, sizeInWords)) { return false; }
+
+        markWords(offsetInWords, sizeInWords, true);
+        return true;
+    }
+
+    // Find the last hole starting at or before the offset
+    auto it = std::upper_bound(holes.begin(), holes.end(), offsetInWords,
+        [](size_t offset, const Hole &hole) { return offset < hole.offset; });
+    if (it == holes.begin()) { return false; }
+    --it;
+
+    // Ensure the hole covers the whole range
+    if ((offsetInWords + sizeInWords) > (it->offset + it->size)) { return false; }
+
+    size_t holeEnd = it->offset + it->size;
+    Hole before = *it;
+
+    if (it->offset == offsetInWords)
+    {
+        // Take the front of the hole
+        it->offset += sizeInWords;
+        it->size -= sizeInWords;
+
+        // Leave no empty hole
+        if (it->size == 0)
+        {
+            holes.erase(it);
+            holeRemoved(before);
+        }
+        else { holeResized(before, *it); }
+    }
+    else if ((offsetInWords + sizeInWords) == holeEnd)
+    {
+        // Take the back of the hole
+        it->size -= sizeInWords;
+        holeResized(before, *it);
+    }
+    else
+    {
+        // Take the middle of the hole, splitting it in two
+        it->size = offsetInWords - it->offset;
+        holeResized(before, *it);
+
+        Hole upperHole { offsetInWords + sizeInWords, holeEnd - (offsetInWords + sizeInWords) };
+        holes.insert(std::next(it), upperHole);
+        holeCreated(upperHole);
+    }
+
+    return true;
+}
+
+size_t MemoryManager::releaseRange(size_t offsetInWords, size_t sizeInWords)
+{
+    markDirty(offsetInWords, sizeInWords);
+
+    if (bitmapEngine)
+    {
+        markWords(offsetInWords, sizeInWords, false);
+        return 0;
+    }
+
+    // Count the holes visited (reported by tracing)
+    size_t holesScanned = 0;
+
+    for (auto it = holes.begin(); it != holes.end(); ++it)
+    {
+        holesScanned++;
+
+        // Check if a hole is adjacent to the left of the deallocated memory
+        if ((it->offset + it->size) == offsetInWords)
+        {
+            Hole before = *it;
+
+            // Extend the hole to the right
+            it->size += sizeInWords;
+
+            // Check if a hole is adjacent to the right of the deallocated memory (double adjacent)
+            auto itNext = std::next(it);
+            if ((itNext != holes.end()) && (itNext->offset == (offsetInWords + sizeInWords)))
+            {
+                // Extend the first hole further right
+                it->size += (itNext)->size; 
+
+                // Remove the 2nd hole (left adjacent)
+                holeRemoved(*itNext);
+                holes.erase(itNext);
+            }
+
+            holeResized(before, *it);
+            return holesScanned;
+        }
+
+        // Check if a hole is only adjacent to the right of the deallocated memory
+        if (it->offset == (offsetInWords + sizeInWords))
+        {
+            Hole before = *it;
+
+            // Extend the hole to the left
+            it->offset -= sizeInWords; 
+            it->size += sizeInWords;
+            holeResized(before, *it);
+            return holesScanned;
+        }
+        
+        // Check if the deallocated memory is left of the current hole but not adjacent to any
+        if (offsetInWords < it->offset)
+        {
+            Hole newHole { offsetInWords, sizeInWords };
+            holes.insert(it, newHole);
+            holeCreated(newHole);
+            return holesScanned;
+        }
+    }
+
+    // Deallocated memory is at the very end and non-adjacent to any hole
+    Hole newHole { offsetInWords, sizeInWords };
+    holes.push_back(newHole);
+    holeCreated(newHole);
+    return holesScanned;
+}
+
+void *MemoryManager::allocateUntracked(size_t sizeInBytes, size_t alignment)
+{
+    if (sizeInBytes == 0) { return nullptr; }
+    if (!memoryBlock) { return nullptr; }
+    if ((alignment == 0) || ((alignment & (alignment - 1)) != 0)) { return nullptr; }
+
+    drainRemoteFrees();
+
+    size_t sizeInWords = toWords(sizeInBytes);
+    if (sizeInWords > this->sizeInWords) { return nullptr; }
+
+    SharedLock guard(this);
+
+    if (((softLimit != 0) || (hardLimit != 0)) && !enforceUsageLimits(sizeInWords * wordSize)) { return nullptr; }
+
+    // Over-aligned requests search the holes directly
+    if ((alignment > naturalAlignment()) && arenaMode) { return nullptr; }
+
+    if (arenaMode)
+    {
+        void *address = bumpAllocate(sizeInWords);
+        publishSummary();
+        return address;
+    }
+
+    bool aligned = alignment > naturalAlignment();
+    uint8_t *address = static_cast<uint8_t *>(aligned ? placeAligned(sizeInWords, alignment) : placeBlock(sizeInWords));
+    if (!address && relieveShortfall(sizeInWords)) { address = static_cast<uint8_t *>(aligned ? placeAligned(sizeInWords, alignment) : placeBlock(sizeInWords)); }
+    if (address) { setBlockStart((address - memoryBlock) / wordSize, true); }
+    publishSummary();
+
+    return address;
+}
+
+void MemoryManager::releaseUntracked(void *address, size_t sizeInBytes)
+{
+    if (!memoryBlock) { return; }
+    if (sizeInBytes == 0) { return; }
+
+    if (isRemoteThread())
+    {
+        pushRemoteFree(address, sizeInBytes);
+        return;
+    }
+
+    releaseUntrackedLocal(address, sizeInBytes);
+}
+
+void MemoryManager::releaseUntrackedLocal(void *address, size_t sizeInBytes)
+{
+    SharedLock guard(this);
+
+    size_t offsetInWords = (static_cast<uint8_t *>(address) - memoryBlock) / wordSize;
+
+    // Arena blocks are only released by resetting the arena
+    if (arenaMode && (offsetInWords >= arenaBase)) { return; }
+
+    // The caller supplies the size, so the block tables are never consulted
+    setBlockStart(offsetInWords, false);
+    releaseRange(offsetInWords, toWords(sizeInBytes));
+    publishSummary();
+    servePending(offsetInWords);
+}
+
+void MemoryManager::pushRemoteFree(void *address, size_t sizeInBytes)
+{
+    RemoteFree *node = new RemoteFree { address, sizeInBytes, nullptr };
+
+    // Push onto the queue head; producers only ever race with each other and the owner's exchange
+    node->next = remoteFrees.load(std::memory_order_relaxed);
+    while (!remoteFrees.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {}
+
+    // Wake a blocked allocateWait; the lock orders this with the waiter's check of the queue
+    if (waiters.load() != 0)
+    {
+        std::lock_guard<std::mutex> lock(waitMutex);
+        freeSignal.notify_all();
+    }
+}
+
+void MemoryManager::drainRemoteFrees()
+{
+    // The first thread to allocate becomes the owner
+    if (ownerThread.load(std::memory_order_relaxed) == std::thread::id()) { ownerThread = std::this_thread::get_id(); }
+
+    // Cheap check so the uncontended path stays a single load
+    if (remoteFrees.load(std::memory_order_relaxed) == nullptr) { return; }
+
+    // Take the whole batch at once
+    RemoteFree *batch = remoteFrees.exchange(nullptr, std::memory_order_acquire);
+
+    // Release each queued block on the owning thread, coalescing into the holes as usual
+    while (batch)
+    {
+        RemoteFree *next = batch->next;
+
+        if (batch->sizeInBytes == 0) { freeLocal(batch->address); }
+        else { releaseUntrackedLocal(batch->address, batch->sizeInBytes); }
+
+        delete batch;
+        batch = next;
+    }
+}
+
+void MemoryManager::setBitmapEngine(bool enabled)
+{
+    if (!memoryBlock) { return; }
+    if (enabled == bitmapEngine) { return; }
+    if (arenaMode) { return; } // The arena works on the hole list
+    if (sharedHeader) { return; } // The segment stores a hole list
+
+    // Blocks are placed first fit from the bitmap, so adaptive selection has nothing to choose between
+    if (enabled) { setAdaptive(false); }
+
+    if (!enabled)
+    {
+        // Hand the holes back to the hole-list allocator
+        syncHoles();
+        holesReset();
+        bitmapEngine = false;
+        usedBits.clear();
+        fullBits.clear();
+        return;
+    }
+
+    // Start with every word used (including the padding past the end of memory)
+    size_t bitWords = (sizeInWords + 63) / 64;
+    usedBits.assign(bitWords, ~0ULL);
+    fullBits.assign((bitWords + 63) / 64, 0);
+    for (size_t i = 0; i < bitWords; i++) { fullBits[i / 64] |= (1ULL << (i % 64)); }
+
+    // Clear the holes (every word starts used, so the summary builds back up from zero)
+    bitmapEngine = true;
+    summaryFreeWords = 0;
+    summaryHoleCount = 0;
+    summaryLargestHole = 0;
+    for (auto it = holes.begin(); it != holes.end(); ++it) { markWords(it->offset, it->size, false); }
+    holesDirty = false;
+}
+
+void MemoryManager::markWords(size_t offsetInWords, size_t sizeInWords, bool used)
+{
+    // The range is wholly free (or wholly used), so it joins or splits the free run around it
+    size_t freeBefore = freeWordsBefore(offsetInWords);
+    size_t freeAfter = freeWordsAfter(offsetInWords + sizeInWords);
+    size_t run = freeBefore + sizeInWords + freeAfter;
+    int neighbours = (freeBefore > 0) + (freeAfter > 0);
+    if (used)
+    {
+        summaryHoleCount = summaryHoleCount + neighbours - 1;
+        if (run >= summaryLargestHole) { summaryLargestStale = true; }
+    }
+    else
+    {
+        summaryHoleCount = summaryHoleCount + 1 - neighbours;
+        summaryLargestHole = std::max(summaryLargestHole, run);
+    }
+
+    size_t first = offsetInWords / 64;
+    size_t last = (offsetInWords + sizeInWords - 1) / 64;
+
+    for (size_t i = first; i <= last; i++)
+    {
+        // Bits of this 64-word group covered by the range
+        size_t low = (i == first) ? (offsetInWords % 64) : 0;
+        size_t high = (i == last) ? ((offsetInWords + sizeInWords - 1) % 64) : 63;
+        uint64_t mask = (~0ULL >> (63 - high)) & (~0ULL << low);
+
+        // The free-word count follows the bits that actually flip
+        size_t usedBefore = __builtin_popcountll(usedBits[i]);
+        if (used) { usedBits[i] |= mask; }
+        else { usedBits[i] &= ~mask; }
+        summaryFreeWords = summaryFreeWords + usedBefore - __builtin_popcountll(usedBits[i]);
+
+        // Keep the summary in step
+        if (usedBits[i] == ~0ULL) { fullBits[i / 64] |= (1ULL << (i % 64)); }
+        else { fullBits[i / 64] &= ~(1ULL << (i % 64)); }
+    }
+
+    summaryDirty = true;
+    holesDirty = true;
+}
+
+size_t MemoryManager::freeWordsBefore(size_t offsetInWords)
+{
+    size_t count = 0;
+    while (offsetInWords > 0)
+    {
+        // Line the word just below the offset up with the top bit
+        size_t bit = (offsetInWords - 1) % 64;
+        uint64_t usedBelow = usedBits[(offsetInWords - 1) / 64] << (63 - bit);
+        if (usedBelow != 0) { return count + __builtin_clzll(usedBelow); }
+
+        count += bit + 1;
+        offsetInWords -= bit + 1;
+    }
+
+    return count;
+}
+
+size_t MemoryManager::freeWordsAfter(size_t offsetInWords)
+{
+    // The padding past the end of memory is marked used, so the walk stops there
+    size_t count = 0;
+    while (offsetInWords < sizeInWords)
+    {
+        size_t bit = offsetInWords % 64;
+        uint64_t usedAbove = usedBits[offsetInWords / 64] >> bit;
+        if (usedAbove != 0) { return count + __builtin_ctzll(usedAbove); }
+
+        count += 64 - bit;
+        offsetInWords += 64 - bit;
+    }
+
+    return count;
+}
+
+size_t MemoryManager::largestFreeRun()
+{
+    size_t largest = 0;
+    size_t run = 0;
+
+    for (size_t i = 0; i < usedBits.size(); i++)
+    {
+        uint64_t usedWord = usedBits[i];
+        size_t position = 0;
+        while (position < 64)
+        {
+            // Free words from the position up to the next used one extend the current run
+            uint64_t usedRest = usedWord >> position;
+            if (usedRest == 0)
+            {
+                run += 64 - position;
+                break;
+            }
+            run += __builtin_ctzll(usedRest);
+            position += __builtin_ctzll(usedRest);
+            largest = std::max(largest, run);
+            run = 0;
+
+            // Skip the used words
+            uint64_t freeRest = ~usedWord >> position;
+            if (freeRest == 0) { break; }
+            position += __builtin_ctzll(freeRest);
+        }
+    }
+
+    return std::max(largest, run);
+}
+
+bool MemoryManager::wordsFree(size_t offsetInWords, size_t sizeInWords)
+{
+    if ((offsetInWords + sizeInWords) > this->sizeInWords) { return false; }
+
+    size_t first = offsetInWords / 64;
+    size_t last = (offsetInWords + sizeInWords - 1) / 64;
+
+    for (size_t i = first; i <= last; i++)
+    {
+        size_t low = (i == first) ? (offsetInWords % 64) : 0;
+        size_t high = (i == last) ? ((offsetInWords + sizeInWords - 1) % 64) : 63;
+        uint64_t mask = (~0ULL >> (63 - high)) & (~0ULL << low);
+
+        if ((usedBits[i] & mask) != 0) { return false; }
+    }
+
+    return true;
+}
+
+long MemoryManager::findFreeRun(size_t sizeInWords)
+{
+    size_t bitWords = usedBits.size();
+
+    // Length and start of the free run that reaches the current group
+    size_t run = 0;
+    size_t runStart = 0;
+
+    size_t i = 0;
+    while (i < bitWords)
+    {
+        // Skip 64 full groups (4096 words) at once using the summary
+        if ((i % 64 == 0) && (fullBits[i / 64] == ~0ULL))
+        {
+            run = 0;
+            i += 64;
+            continue;
+        }
+
+#ifdef __AVX2__
+        // Skip four full groups per compare
+        if ((run == 0) && (i + 4 <= bitWords))
+        {
+            __m256i groups = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&usedBits[i]));
+            if (_mm256_testc_si256(groups, _mm256_set1_epi64x(-1)))
+            {
+                i += 4;
+                continue;
+            }
+        }
+#endif
+
+        uint64_t freeBits = ~usedBits[i];
+
+        if (freeBits == 0)
+        {
+            // Fully used group breaks any run
+            run = 0;
+            i++;
+            continue;
+        }
+
+        if (freeBits == ~0ULL)
+        {
+            // Fully free group extends the run
+            if (run == 0) { runStart = i * 64; }
+            run += 64;
+            if (run >= sizeInWords) { return runStart; }
+            i++;
+            continue;
+        }
+
+        // Free words at the bottom of the group continue the run from the previous group
+        size_t position = __builtin_ctzll(~freeBits);
+        if (position > 0)
+        {
+            if (run == 0) { runStart = i * 64; }
+            run += position;
+            if (run >= sizeInWords) { return runStart; }
+        }
+
+        // Look at the runs inside the group
+        run = 0;
+        while (position < 64)
+        {
+            uint64_t rest = freeBits >> position;
+            if (rest == 0) { break; }
+
+            // Jump to the start of the next free run
+            position += __builtin_ctzll(rest);
+
+            uint64_t usedAfter = (~freeBits) >> position;
+            if (usedAfter == 0)
+            {
+                // Free up to the top of the group: carry the run into the next group
+                runStart = (i * 64) + position;
+                run = 64 - position;
+                if (run >= sizeInWords) { return runStart; }
+                break;
+            }
+
+            size_t length = __builtin_ctzll(usedAfter);
+            if (length >= sizeInWords) { return (i * 64) + position; }
+            position += length;
+        }
+
+        i++;
+    }
+
+    // No run is long enough
+    return -1;
+}
+
+void MemoryManager::syncHoles()
+{
+    if (!bitmapEngine || !holesDirty) { return; }
+
+    holes.clear();
+
+    // Walk the free runs of the bitmap, 64 words at a time
+    size_t runStart = 0;
+    bool inRun = false;
+
+    for (size_t i = 0; i < usedBits.size(); i++)
+    {
+        uint64_t freeBits = ~usedBits[i];
+
+        if ((freeBits == 0) && !inRun) { continue; }
+        if ((freeBits == ~0ULL) && inRun) { continue; }
+
+        size_t position = 0;
+        while (position < 64)
+        {
+            // Bits still to look at, shifted down to the current position
+            uint64_t rest = freeBits >> position;
+
+            if (!inRun)
+            {
+                if (rest == 0) { break; }
+                position += __builtin_ctzll(rest);
+                runStart = (i * 64) + position;
+                inRun = true;
+            }
+            else
+            {
+                uint64_t usedRest = (~freeBits) >> position;
+                if (usedRest == 0) { break; }
+                position += __builtin_ctzll(usedRest);
+                holes.push_back(Hole { runStart, ((i * 64) + position) - runStart });
+                inRun = false;
+            }
+        }
+    }
+
+    // The padding past the end of memory is marked used, so runs always close above
+    if (inRun) { holes.push_back(Hole { runStart, sizeInWords - runStart }); }
+
+    holesDirty = false;
+    holesReset();
+    publishSummary();
+}
+
+int MemoryManager::initializeShared(const char *name, size_t sizeInWords)
+{
+    if (sizeInWords == 0 || wordSize == 0) { return -1; }
+    if (sizeInWords > 65536) { return -1; }
+    if (memoryBlock != nullptr) { shutdown(); }
+
+    return mapShared(name, true, sizeInWords);
+}
+
+int MemoryManager::attachShared(const char *name)
+{
+    if (wordSize == 0) { return -1; }
+    if (memoryBlock != nullptr) { shutdown(); }
+
+    return mapShared(name, false, 0);
+}
+
+int MemoryManager::mapShared(const char *name, bool create, size_t sizeInWords)
+{
+    // Open (or create) the segment
+    int sharedFile = shm_open(name, create ? (O_CREAT | O_EXCL | O_RDWR) : O_RDWR, 0600);
+    if (sharedFile == -1) { return -1; }
+
+    size_t totalBytes = 0;
+    if (create)
+    {
+        // Lay out the header, hole array, block size table and memory block, each on a cache line
+        size_t maxHoles = (sizeInWords / 2) + 1;
+        size_t holesOffset = (sizeof(SharedHeader) + 63) & ~static_cast<size_t>(63);
+        size_t blockSizesOffset = (holesOffset + (maxHoles * sizeof(Hole)) + 63) & ~static_cast<size_t>(63);
+        size_t memoryOffset = (blockSizesOffset + (sizeInWords * sizeof(uint32_t)) + 63) & ~static_cast<size_t>(63);
+        totalBytes = memoryOffset + (sizeInWords * wordSize);
+
+        // A new segment is zero filled, so every block size starts at 0
+        if (ftruncate(sharedFile, totalBytes) == -1)
+        {
+            close(sharedFile);
+            shm_unlink(name);
+            return -1;
+        }
+
+        void *mapping = mmap(nullptr, totalBytes, PROT_READ | PROT_WRITE, MAP_SHARED, sharedFile, 0);
+        close(sharedFile);
+        if (mapping == MAP_FAILED)
+        {
+            shm_unlink(name);
+            return -1;
+        }
+
+        SharedHeader *header = static_cast<SharedHeader *>(mapping);
+        header->wordSize = wordSize;
+        header->sizeInWords = sizeInWords;
+        header->maxHoles = maxHoles;
+        header->holesOffset = holesOffset;
+        header->blockSizesOffset = blockSizesOffset;
+        header->memoryOffset = memoryOffset;
+
+        // Build the big hole
+        Hole *sharedHoles = reinterpret_cast<Hole *>(static_cast<uint8_t *>(mapping) + holesOffset);
+        sharedHoles[0] = Hole { 0, sizeInWords };
+        header->holeCount = 1;
+        header->generation = 1;
+
+        // Recursive so nested public calls can re-lock; robust so a crashed process does not wedge the others
+        pthread_mutexattr_t attributes;
+        pthread_mutexattr_init(&attributes);
+        pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+        pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&header->lock, &attributes);
+        pthread_mutexattr_destroy(&attributes);
+
+        // Publish the heap
+        header->magic.store(SharedMagic, std::memory_order_release);
+
+        sharedHeader = header;
+    }
+    else
+    {
+        struct stat sharedStat;
+        if ((fstat(sharedFile, &sharedStat) == -1) || (static_cast<size_t>(sharedStat.st_size) < sizeof(SharedHeader)))
+        {
+            close(sharedFile);
+            return -1;
+        }
+        totalBytes = sharedStat.st_size;
+
+        void *mapping = mmap(nullptr, totalBytes, PROT_READ | PROT_WRITE, MAP_SHARED, sharedFile, 0);
+        close(sharedFile);
+        if (mapping == MAP_FAILED) { return -1; }
+
+        // Ensure the heap is fully built, uses the same word size and the segment really holds all of it
+        SharedHeader *header = static_cast<SharedHeader *>(mapping);
+        if ((header->magic.load(std::memory_order_acquire) != SharedMagic) || (header->wordSize != wordSize) ||
+            (totalBytes < header->memoryOffset + (header->sizeInWords * wordSize)))
+        {
+            munmap(mapping, totalBytes);
+            return -1;
+        }
+
+        sharedHeader = header;
+        sizeInWords = header->sizeInWords;
+    }
+
+    sharedBytes = totalBytes;
+    sharedName = name;
+    sharedCreator = create;
+    sharedDepth = 0;
+    sharedGeneration = 0; // Never a live generation, so the first lock loads the holes
+
+    memoryBlock = reinterpret_cast<uint8_t *>(sharedHeader) + sharedHeader->memoryOffset;
+    this->sizeInWords = sizeInWords;
+    ownerThread = std::thread::id();
+
+    return 0;
+}
+
+uint32_t *MemoryManager::sharedBlockSizes()
+{
+    return reinterpret_cast<uint32_t *>(reinterpret_cast<uint8_t *>(sharedHeader) + sharedHeader->blockSizesOffset);
+}
+
+bool MemoryManager::sharedHolesValid()
+{
+    if (sharedHeader->holeCount > sharedHeader->maxHoles) { return false; }
+
+    // Holes must be non-empty, in bounds, sorted and separated by at least one used word
+    Hole *sharedHoles = reinterpret_cast<Hole *>(reinterpret_cast<uint8_t *>(sharedHeader) + sharedHeader->holesOffset);
+    size_t end = 0;
+    for (size_t i = 0; i < sharedHeader->holeCount; ++i)
+    {
+        const Hole &hole = sharedHoles[i];
+        if ((hole.size == 0) || (hole.offset > sharedHeader->sizeInWords) || (hole.size > sharedHeader->sizeInWords - hole.offset)) { return false; }
+        if ((i > 0) && (hole.offset <= end)) { return false; }
+        end = hole.offset + hole.size;
+    }
+
+    return true;
+}
+
+void MemoryManager::rebuildSharedHoles()
+{
+    // The block size table is written before the holes, so the gaps between its blocks are the holes
+    uint32_t *blockSizes = sharedBlockSizes();
+    Hole *sharedHoles = reinterpret_cast<Hole *>(reinterpret_cast<uint8_t *>(sharedHeader) + sharedHeader->holesOffset);
+    size_t holeCount = 0;
+    size_t offset = 0;
+    while (offset < sharedHeader->sizeInWords)
+    {
+        if (blockSizes[offset] != 0)
+        {
+            offset += blockSizes[offset];
+            continue;
+        }
+
+        size_t start = offset;
+        while ((offset < sharedHeader->sizeInWords) && (blockSizes[offset] == 0)) { ++offset; }
+        sharedHoles[holeCount++] = Hole { start, offset - start };
+    }
+    sharedHeader->holeCount = holeCount;
+
+    // Every process reloads the rebuilt table on its next lock
+    ++sharedHeader->generation;
+}
+
+size_t MemoryManager::offsetOf(void *address) { return static_cast<uint8_t *>(address) - memoryBlock; }
+
+void *MemoryManager::addressOf(size_t offsetInBytes) { return memoryBlock + offsetInBytes; }
+
+size_t MemoryManager::getTagBytes(uint8_t tag) { return tagBytes[tag]; }
+
+void MemoryManager::freeAllWithTag(uint8_t tag)
+{
+    if (!memoryBlock) { return; }
+    if (sharedHeader) { return; } // Shared heaps do not store tags
+    if (tagBytes[tag] == 0) { return; }
+
+    drainRemoteFrees();
+
+    // Unmap the tag's direct mappings
+    for (auto it = directMappings.begin(); it != directMappings.end();)
+    {
+        if (it->second.tag != tag)
+        {
+            ++it;
+            continue;
+        }
+
+        directBytes -= directMappedBytes(it->second.sizeInWords);
+        munmap(it->first, directMappedBytes(it->second.sizeInWords));
+        it = directMappings.erase(it);
+    }
+
+    // Pull the tag's blocks out of the tables; walking the block starts yields them sorted by address
+    std::vector<Hole> released;
+    for (size_t i = 0; i < blockStarts.size(); i++)
+    {
+        for (uint64_t bits = blockStarts[i]; bits != 0; bits &= bits - 1)
+        {
+            size_t offsetInWords = (i * 64) + __builtin_ctzll(bits);
+            if ((blockSizes[offsetInWords] == 0) || (blockTags[offsetInWords] != tag)) { continue; }
+
+            released.push_back(Hole { offsetInWords, blockSizes[offsetInWords] });
+            if (recorder) { recordOp(RecordOp::Free, released.back().size, released.back().offset); }
+            setBlockStart(offsetInWords, false);
+            countStraddles(memoryBlock + (offsetInWords * wordSize), blockSizes[offsetInWords], false);
+            if (!bitmapEngine) { markDirty(offsetInWords, blockSizes[offsetInWords]); }
+            blockSizes[offsetInWords] = 0;
+            liveBlocks--;
+        }
+    }
+
+    tagBytes[tag] = 0;
+
+    if (bitmapEngine)
+    {
+        for (auto it = released.begin(); it != released.end(); ++it) { releaseRange(it->offset, it->size); }
+        publishSummary();
+        servePending(SIZE_MAX);
+        return;
+    }
+
+    // Merge the released blocks into the holes in one sweep, coalescing neighbours as they meet
+    std::vector<Hole> merged;
+    merged.reserve(holes.size() + released.size());
+
+    auto holeIt = holes.begin();
+    auto releasedIt = released.begin();
+    while ((holeIt != holes.end()) || (releasedIt != released.end()))
+    {
+        // Take whichever range starts first
+        Hole next;
+        if ((releasedIt == released.end()) || ((holeIt != holes.end()) && (holeIt->offset < releasedIt->offset)))
+        {
+            next = *holeIt;
+            ++holeIt;
+        }
+        else
+        {
+            next = *releasedIt;
+            ++releasedIt;
+        }
+
+        if (!merged.empty() && ((merged.back().offset + merged.back().size) == next.offset)) { merged.back().size += next.size; }
+        else { merged.push_back(next); }
+    }
+
+    holes.swap(merged);
+    holesReset();
+    publishSummary();
+
+    servePending(SIZE_MAX);
+}
+
+// Built-in policies the adaptive selector chooses between
+static int (*const adaptivePolicies[2])(int, void *) = { bestFit, worstFit };
+static const char *const adaptivePolicyNames[2] = { "bestFit", "worstFit" };
+
+void MemoryManager::setAdaptive(bool enabled)
+{
+    if (enabled == adaptive) { return; }
+    if (enabled && bitmapEngine) { return; } // The bitmap engine places blocks itself, so there is nothing to choose
+    adaptive = enabled;
+
+    if (!enabled)
+    {
+        // Hand placement back to whatever the caller had chosen
+        allocator = savedAllocator;
+        savedAllocator = nullptr;
+        if (savedPolicy)
+        {
+            SharedLock guard(this);
+            syncHoles();
+
+            // The policy missed every hole change while the selector ran
+            policy = savedPolicy;
+            savedPolicy = nullptr;
+            policy->onHolesReset(holes);
+        }
+        return;
+    }
+
+    // The selector drives the allocator function, so a policy would bypass it
+    savedAllocator = allocator;
+    savedPolicy = policy;
+    policy = nullptr;
+
+    // Start a fresh history on bestFit
+    adaptiveHome = 0;
+    adaptiveActive = 0;
+    adaptiveExploring = false;
+    adaptiveScored[0] = false;
+    adaptiveScored[1] = false;
+    adaptiveOps = 0;
+    adaptiveFailures = 0;
+    adaptiveScanned = 0;
+    adaptiveWindows = 0;
+    adaptiveWindowsSinceExplore = 0;
+    adaptiveSwitches = 0;
+
+    allocator = adaptivePolicies[adaptiveActive];
+}
+
+size_t MemoryManager::adaptiveScanCount(size_t sizeInWords)
+{
+    // worstFit reads every hole; bestFit stops at the first exact fit
+    if (adaptiveActive != 0) { return holes.size(); }
+
+    auto exact = std::find_if(holes.begin(), holes.end(), [sizeInWords](const Hole &hole) { return hole.size == sizeInWords; });
+    return (exact == holes.end()) ? holes.size() : (exact - holes.begin()) + 1;
+}
+
+double MemoryManager::currentFragmentation()
+{
+    // 0 when all free memory is one hole, approaching 1 as it splinters
+    size_t freeWords = 0;
+    size_t largestHole = 0;
+    for (auto it = holes.begin(); it != holes.end(); ++it)
+    {
+        freeWords += it->size;
+        largestHole = std::max(largestHole, it->size);
+    }
+
+    if (freeWords == 0) { return 0; }
+    return 1.0 - (static_cast<double>(largestHole) / freeWords);
+}
+
+void MemoryManager::adaptiveRecord(size_t sizeInWords, bool succeeded, size_t holesScanned)
+{
+    adaptiveOps++;
+    adaptiveScanned += holesScanned;
+
+    // Only failures caused by fragmentation count against the policy
+    if (!succeeded)
+    {
+        size_t freeWords = 0;
+        for (auto it = holes.begin(); it != holes.end(); ++it) { freeWords += it->size; }
+        if (freeWords >= sizeInWords) { adaptiveFailures++; }
+    }
+
+    if (adaptiveOps < AdaptiveWindow) { return; }
+
+    // Score the window: fragmentation, fragmentation failures, and a small weight on search cost
+    double failureRate = static_cast<double>(adaptiveFailures) / adaptiveOps;
+    double averageScanned = static_cast<double>(adaptiveScanned) / adaptiveOps;
+    double windowScore = currentFragmentation() + (2.0 * failureRate) + (0.001 * averageScanned);
+
+    // Smooth it into the policy's running score
+    if (adaptiveScored[adaptiveActive]) { adaptiveScores[adaptiveActive] = (0.5 * adaptiveScores[adaptiveActive]) + (0.5 * windowScore); }
+    else { adaptiveScores[adaptiveActive] = windowScore; }
+    adaptiveScored[adaptiveActive] = true;
+
+    adaptiveOps = 0;
+    adaptiveFailures = 0;
+    adaptiveScanned = 0;
+    adaptiveWindows++;
+    adaptiveWindowsSinceExplore++;
+
+    if (adaptiveExploring)
+    {
+        // Keep the explored policy only when it clearly wins
+        adaptiveExploring = false;
+        if (adaptiveScores[adaptiveActive] < (0.9 * adaptiveScores[adaptiveHome]))
+        {
+            adaptiveHome = adaptiveActive;
+            adaptiveSwitches++;
+        }
+        adaptiveActive = adaptiveHome;
+    }
+    else if (adaptiveWindowsSinceExplore >= AdaptiveExploreEvery)
+    {
+        // Give the other policy a window to refresh its score
+        adaptiveExploring = true;
+        adaptiveActive = 1 - adaptiveHome;
+        adaptiveWindowsSinceExplore = 0;
+    }
+
+    allocator = adaptivePolicies[adaptiveActive];
+}
+
+MemoryStats MemoryManager::getStats()
+{
+    MemoryStats stats;
+    if (!memoryBlock) { return stats; }
+
+    SharedLock guard(this);
+    syncHoles();
+
+    // Hole summary
+    for (auto it = holes.begin(); it != holes.end(); ++it)
+    {
+        stats.freeWords += it->size;
+        stats.largestHole = std::max(stats.largestHole, it->size);
+    }
+    stats.holeCount = holes.size();
+
+    if (sharedHeader)
+    {
+        uint32_t *blockSizes = sharedBlockSizes();
+        for (size_t i = 0; i < sizeInWords; i++) { stats.allocationCount += (blockSizes[i] != 0); }
+    }
+    else
+    {
+        stats.allocationCount = liveBlocks;
+    }
+    stats.lineStraddlingBlocks = lineStraddlers;
+    stats.pageStraddlingBlocks = pageStraddlers;
+
+    // Direct mappings
+    stats.directMappedCount = directMappings.size();
+    stats.directMappedBytes = directBytes;
+
+    // Adaptive selection state
+    stats.adaptive = adaptive;
+    stats.adaptivePolicy = adaptive ? adaptivePolicyNames[adaptiveHome] : "";
+    stats.adaptiveSwitches = adaptiveSwitches;
+    stats.adaptiveWindows = adaptiveWindows;
+    stats.bestFitScore = adaptiveScores[0];
+    stats.worstFitScore = adaptiveScores[1];
+
+    return stats;
+}
+
+HeapSummary MemoryManager::getSummary()
+{
+    HeapSummary summary;
+
+    // Seqlock read: retry until no write overlapped the copy
+    while (true)
+    {
+        uint64_t before = summarySequence.load(std::memory_order_acquire);
+        if (before & 1) { continue; }
+
+        summary.freeWords = publishedFreeWords.load(std::memory_order_relaxed);
+        summary.largestHole = publishedLargestHole.load(std::memory_order_relaxed);
+        summary.holeCount = publishedHoleCount.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (summarySequence.load(std::memory_order_relaxed) == before) { return summary; }
+    }
+}
+
+void MemoryManager::holeCreated(const Hole &hole)
+{
+    summaryFreeWords += hole.size;
+    summaryHoleCount++;
+    summaryLargestHole = std::max(summaryLargestHole, hole.size);
+    summaryDirty = true;
+
+    if (policy) { policy->onHoleCreated(hole); }
+}
+
+void MemoryManager::holeResized(const Hole &before, const Hole &after)
+{
+    summaryFreeWords = summaryFreeWords + after.size - before.size;
+    if (after.size > summaryLargestHole) { summaryLargestHole = after.size; }
+    else if ((before.size == summaryLargestHole) && (after.size < before.size)) { summaryLargestStale = true; }
+    summaryDirty = true;
+
+    if (policy) { policy->onHoleResized(before, after); }
+}
+
+void MemoryManager::holeRemoved(const Hole &hole)
+{
+    summaryFreeWords -= hole.size;
+    summaryHoleCount--;
+    if (hole.size == summaryLargestHole) { summaryLargestStale = true; }
+    summaryDirty = true;
+
+    if (policy) { policy->onHoleRemoved(hole); }
+}
+
+void MemoryManager::holesReset()
+{
+    summaryFreeWords = 0;
+    summaryLargestHole = 0;
+    for (auto it = holes.begin(); it != holes.end(); ++it)
+    {
+        summaryFreeWords += it->size;
+        summaryLargestHole = std::max(summaryLargestHole, it->size);
+    }
+    summaryHoleCount = holes.size();
+    summaryLargestStale = false;
+    summaryDirty = true;
+
+    if (policy) { policy->onHolesReset(holes); }
+}
+
+void MemoryManager::publishSummary()
+{
+    if (!summaryDirty) { return; }
+
+    // Only a shrinking largest hole needs a full scan (of the bitmap when the engine owns placement)
+    if (summaryLargestStale)
+    {
+        summaryLargestHole = 0;
+        if (bitmapEngine) { summaryLargestHole = largestFreeRun(); }
+        else
+        {
+            for (auto it = holes.begin(); it != holes.end(); ++it) { summaryLargestHole = std::max(summaryLargestHole, it->size); }
+        }
+        summaryLargestStale = false;
+    }
+
+    // Seqlock write: odd sequence while the fields change
+    uint64_t sequence = summarySequence.load(std::memory_order_relaxed);
+    summarySequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    publishedFreeWords.store(summaryFreeWords, std::memory_order_relaxed);
+    publishedLargestHole.store(summaryLargestHole, std::memory_order_relaxed);
+    publishedHoleCount.store(summaryHoleCount, std::memory_order_relaxed);
+
+    summarySequence.store(sequence + 2, std::memory_order_release);
+    summaryDirty = false;
+}
+
+void MemoryManager::setDirectMapThreshold(size_t sizeInBytes) { directMapThreshold = sizeInBytes; }
+
+void MemoryManager::setBoundaryThreshold(size_t sizeInBytes) { boundaryThreshold = sizeInBytes; }
+
+size_t MemoryManager::addPressureCallback(std::function<void(size_t)> callback, int priority)
+{
+    if (!callback) { return 0; }
+
+    // Keep the list sorted by priority, in registration order among equals
+    auto position = std::upper_bound(pressureCallbacks.begin(), pressureCallbacks.end(), priority,
+        [](int priority, const PressureCallback &entry) { return priority < entry.priority; });
+    pressureCallbacks.insert(position, PressureCallback { nextPressureId, priority, callback });
+
+    return nextPressureId++;
+}
+
+void MemoryManager::removePressureCallback(size_t id)
+{
+    auto it = std::find_if(pressureCallbacks.begin(), pressureCallbacks.end(), [id](const PressureCallback &entry) { return entry.id == id; });
+    if (it != pressureCallbacks.end()) { pressureCallbacks.erase(it); }
+}
+
+void MemoryManager::setUsageLimits(size_t softLimitInBytes, size_t hardLimitInBytes)
+{
+    softLimit = softLimitInBytes;
+    hardLimit = hardLimitInBytes;
+}
+
+size_t MemoryManager::usedBytes()
+{
+    // The summary's free count is exact in both engines, and direct mappings count by their mapped size
+    return ((sizeInWords - summaryFreeWords) * wordSize) + directBytes;
+}
+
+bool MemoryManager::enforceUsageLimits(size_t requestBytes)
+{
+    if (relievingPressure) { return true; }
+
+    size_t usage = usedBytes() + requestBytes;
+
+    // Hard limit: ask for enough back to stay under it, and refuse if that is not enough
+    if ((hardLimit != 0) && (usage > hardLimit))
+    {
+        relievePressure(usage - hardLimit, [this, requestBytes]() { return (usedBytes() + requestBytes) <= hardLimit; });
+        usage = usedBytes() + requestBytes;
+        if (usage > hardLimit) { return false; }
+    }
+
+    // Soft limit: ask for memory back but allocate either way
+    if ((softLimit != 0) && (usage > softLimit))
+    {
+        relievePressure(usage - softLimit, [this, requestBytes]() { return (usedBytes() + requestBytes) <= softLimit; });
+    }
+
+    return true;
+}
+
+bool MemoryManager::relieveShortfall(size_t sizeInWords)
+{
+    if (pressureCallbacks.empty() || relievingPressure) { return false; }
+
+    // Ask for the gap between the request and the largest hole, stopping once a big enough hole exists
+    syncHoles();
+    size_t shortfallInWords = (sizeInWords > summaryLargestHole) ? (sizeInWords - summaryLargestHole) : 1;
+    relievePressure(shortfallInWords * wordSize, [this, sizeInWords]() { syncHoles(); publishSummary(); return summaryLargestHole >= sizeInWords; });
+
+    return true;
+}
+
+void MemoryManager::relievePressure(size_t shortfallInBytes, std::function<bool()> relieved)
+{
+    relievingPressure = true;
+
+    // Callbacks may add or remove callbacks, so walk a copy
+    std::vector<PressureCallback> callbacks = pressureCallbacks;
+    for (auto it = callbacks.begin(); it != callbacks.end(); ++it)
+    {
+        it->callback(shortfallInBytes);
+        if (relieved()) { break; }
+    }
+
+    relievingPressure = false;
+}
+
+// True if [start, start + length) crosses a multiple of boundary
+static bool crossesBoundary(uintptr_t start, size_t length, size_t boundary) { return (start / boundary) != ((start + length - 1) / boundary); }
+
+size_t MemoryManager::avoidBoundaries(size_t offsetInWords, size_t sizeInWords)
+{
+    size_t sizeInBytes = sizeInWords * wordSize;
+    bool lineFits = sizeInBytes <= CacheLineBytes;
+    bool pageFits = sizeInBytes <= PageBytes;
+
+    uintptr_t start = reinterpret_cast<uintptr_t>(memoryBlock + (offsetInWords * wordSize));
+    bool crossesLine = lineFits && crossesBoundary(start, sizeInBytes, CacheLineBytes);
+    bool crossesPage = pageFits && crossesBoundary(start, sizeInBytes, PageBytes);
+    if (!crossesLine && !crossesPage) { return offsetInWords; }
+
+    // Find the hole the allocator chose
+    auto hole = std::upper_bound(holes.begin(), holes.end(), offsetInWords,
+        [](size_t offset, const Hole &hole) { return offset < hole.offset; });
+    if (hole == holes.begin()) { return offsetInWords; }
+    --hole;
+    size_t lastStart = hole->offset + hole->size - sizeInWords;
+
+    // Try the first word at or after the next line, then the next page, that keeps the block in the hole
+    uintptr_t base = reinterpret_cast<uintptr_t>(memoryBlock);
+    size_t boundaries[2] = { CacheLineBytes, PageBytes };
+    for (size_t i = 0; i < 2; i++)
+    {
+        uintptr_t next = ((start / boundaries[i]) + 1) * boundaries[i];
+        size_t candidate = ((next - base) + wordSize - 1) / wordSize;
+        if (candidate > lastStart) { continue; }
+
+        uintptr_t candidateStart = base + (candidate * wordSize);
+        if (lineFits && crossesBoundary(candidateStart, sizeInBytes, CacheLineBytes)) { continue; }
+        if (pageFits && crossesBoundary(candidateStart, sizeInBytes, PageBytes)) { continue; }
+
+        return candidate;
+    }
+
+    // No better spot in this hole
+    return offsetInWords;
+}
+
+void MemoryManager::countStraddles(uint8_t *address, size_t sizeInWords, bool added)
+{
+    size_t sizeInBytes = sizeInWords * wordSize;
+    uintptr_t start = reinterpret_cast<uintptr_t>(address);
+
+    if ((sizeInBytes <= CacheLineBytes) && crossesBoundary(start, sizeInBytes, CacheLineBytes)) { added ? lineStraddlers++ : lineStraddlers--; }
+    if ((sizeInBytes <= PageBytes) && crossesBoundary(start, sizeInBytes, PageBytes)) { added ? pageStraddlers++ : pageStraddlers--; }
+}
+
+size_t MemoryManager::directMappedBytes(size_t sizeInWords)
+{
+    // Mappings are whole pages
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    return (((sizeInWords * wordSize) + pageSize - 1) / pageSize) * pageSize;
+}
+
+void *MemoryManager::allocateDirect(size_t sizeInBytes, uint8_t tag)
+{
+    size_t sizeInWords = toWords(sizeInBytes);
+    if (sizeInWords > UINT32_MAX) { return nullptr; }
+
+    void *mapping = mmap(nullptr, directMappedBytes(sizeInWords), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) { return nullptr; }
+
+    // Track it like any other block so free, tags and stats see it
+    uint8_t *address = static_cast<uint8_t *>(mapping);
+    directMappings[address] = Allocation { static_cast<uint32_t>(sizeInWords), tag };
+    directBytes += directMappedBytes(sizeInWords);
+    tagBytes[tag] += sizeInWords * wordSize;
+
+    return address;
+}
+
+bool MemoryManager::freeDirect(void *address)
+{
+    auto it = directMappings.find(static_cast<uint8_t *>(address));
+    if (it == directMappings.end()) { return false; }
+
+    tagBytes[it->second.tag] -= it->second.sizeInWords * wordSize;
+    directBytes -= directMappedBytes(it->second.sizeInWords);
+    munmap(it->first, directMappedBytes(it->second.sizeInWords));
+    directMappings.erase(it);
+
+    return true;
+}
+
+int MemoryManager::startRecording(char *filename)
+{
+    if (!memoryBlock) { return -1; }
+    stopRecording();
+
+    // Open/create the file for writing
+    int openedFile = open(filename, O_TRUNC | O_CREAT | O_WRONLY, 0644);
+    if (openedFile == -1) { return -1; }
+
+    recorder = new Recorder();
+    recorder->file = openedFile;
+    recorder->last = std::chrono::steady_clock::now();
+
+    // Header: magic, version, word size, size in words
+    uint8_t *out = recorder->active;
+    memcpy(out, TraceRecordMagic, sizeof(TraceRecordMagic));
+    out += sizeof(TraceRecordMagic);
+    *out++ = TraceRecordVersion;
+    out = writeVarint(out, wordSize);
+    out = writeVarint(out, sizeInWords);
+    recorder->used = out - recorder->active;
+
+    // The writer sleeps until a full buffer is handed over
+    Recorder *activeRecorder = recorder;
+    recorder->writer = std::thread([activeRecorder]()
+    {
+        std::unique_lock<std::mutex> lock(activeRecorder->lock);
+        while (true)
+        {
+            activeRecorder->wake.wait(lock, [activeRecorder]() { return activeRecorder->pending || activeRecorder->stopping; });
+            if (!activeRecorder->pending) { break; }
+
+            // Write without holding the lock so the allocating thread can keep filling the other buffer
+            uint8_t *buffer = activeRecorder->pending;
+            size_t length = activeRecorder->pendingUsed;
+            lock.unlock();
+            write(activeRecorder->file, buffer, length);
+            lock.lock();
+
+            activeRecorder->pending = nullptr;
+            activeRecorder->done.notify_all();
+        }
+    });
+
+    recordLiveBlocks();
+
+    return 0;
+}
+
+void MemoryManager::recordLiveBlocks()
+{
+    SharedLock guard(this);
+
+    // Blocks allocated before recording started open the trace, so their frees replay
+    if (sharedHeader)
+    {
+        uint32_t *blockSizes = sharedBlockSizes();
+        for (size_t i = 0; i < sizeInWords; i++)
+        {
+            if (blockSizes[i] != 0) { writeRecord(RecordOp::Allocate, 0, blockSizes[i], i); }
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < blockStarts.size(); i++)
+    {
+        for (uint64_t bits = blockStarts[i]; bits != 0; bits &= bits - 1)
+        {
+            size_t offsetInWords = (i * 64) + __builtin_ctzll(bits);
+            if (blockSizes[offsetInWords] != 0) { writeRecord(RecordOp::Allocate, 0, blockSizes[offsetInWords], offsetInWords); }
+        }
+    }
+}
+
+void MemoryManager::stopRecording()
+{
+    if (!recorder) { return; }
+
+    // Hand over what is left, then let the writer finish
+    flushRecording();
     {
-        holeList[index] = it->offset;
-        index++;
-        holeList[index] = it->size;
-        index++;
+        std::lock_guard<std::mutex> lock(recorder->lock);
+        recorder->stopping = true;
     }
+    recorder->wake.notify_one();
+    recorder->writer.join();
 
-    return holeList;
+    close(recorder->file);
+    delete recorder;
+    recorder = nullptr;
 }
 
-void *MemoryManager::allocate(size_t sizeInBytes)
+void MemoryManager::recordOp(RecordOp op, size_t sizeInWords, size_t offsetInWords)
 {
-    if (sizeInBytes == 0) { return nullptr; }
-    if (!memoryBlock) { return nullptr; }
-
-    // Calculate the size in words needed for the allocation
-    size_t sizeInWords = sizeInBytes / wordSize;
-    size_t remainder = sizeInBytes % wordSize; // Check for a remainder
-    if (remainder > 0) { sizeInWords++; } // If there is a remainder, bump up by one word
-    
-    // Ensure the size in words does not exceed memory size
-    if (sizeInWords > this->sizeInWords) { return nullptr; }
-    
-    // Fetch the hole list
-    void *holeList = getList();
-    
-    // Call the allocator function to get the offset in words
-    int offset = allocator(sizeInWords, holeList);
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    uint64_t delta = std::chrono::duration_cast<std::chrono::nanoseconds>(now - recorder->last).count();
+    recorder->last = now;
 
-    delete[] static_cast<uint16_t*>(holeList);
-    
-    // Ensure allocation worked
-    if (offset == -1) { return nullptr; }
+    writeRecord(op, delta, sizeInWords, offsetInWords);
+}
 
-    // Convert the offset in words to a size_t
-    size_t offsetInWords = static_cast<size_t>(offset);
+void MemoryManager::writeRecord(RecordOp op, uint64_t delta, size_t sizeInWords, size_t offsetInWords)
+{
+    // Swap buffers before a record could overflow
+    if ((Recorder::BufferSize - recorder->used) < Recorder::MaxRecord) { flushRecording(); }
 
-    // Convert the offset in words to an offset in bytes
-    size_t offsetInBytes = (offsetInWords * wordSize);
-    
-    // Update the fitting hole
-    // Search through hole list
-    for (auto it = holes.begin(); it != holes.end(); ++it)
-    {
-        // If offset of hole matches, hole is matched
-        if (it->offset == offsetInWords)
-        {
-            it->offset += sizeInWords;
-            it->size -= sizeInWords;
+    uint8_t *out = recorder->active + recorder->used;
+    *out++ = static_cast<uint8_t>(op);
+    out = writeVarint(out, delta);
+    out = writeVarint(out, sizeInWords);
+    if (op != RecordOp::FailedAllocate) { out = writeVarint(out, offsetInWords); }
 
-            // Leave no empty hole
-            if (it->size == 0) { holes.erase(it); }
+    recorder->used = out - recorder->active;
+}
 
-            break;
-        }
-    }
+void MemoryManager::flushRecording()
+{
+    std::unique_lock<std::mutex> lock(recorder->lock);
 
-    // Calculate the allocation address for the allocation map
-    uint8_t *allocationAddress = (memoryBlock + offsetInBytes);
+    // Wait for the writer to finish the previous buffer
+    recorder->done.wait(lock, [this]() { return recorder->pending == nullptr; });
 
-    allocations[allocationAddress] = sizeInWords;
+    // Hand over the active buffer and continue in the other one
+    recorder->pending = recorder->active;
+    recorder->pendingUsed = recorder->used;
+    recorder->active = (recorder->active == recorder->buffers[0]) ? recorder->buffers[1] : recorder->buffers[0];
+    recorder->used = 0;
 
-    // Return a pointer to the newly allocated memory
-    return (memoryBlock + offsetInBytes);
+    recorder->wake.notify_one();
 }
 
-void MemoryManager::free(void *address)
+// Address-range chunks for the parallel reports: chunk i covers words [bounds[i], bounds[i + 1]), each a multiple of 8
+static std::vector<size_t> chunkBounds(size_t sizeInWords, unsigned threads)
 {
-    if (!memoryBlock) { return; }
+    // More chunks than cores only adds thread start-up cost
+    unsigned cores = std::thread::hardware_concurrency();
+    if ((cores != 0) && (threads > cores)) { threads = cores; }
+    if (threads == 0) { threads = 1; }
 
-    // If the given address in before or after the memory block, return null
-    if ((address < memoryBlock) || (address >= memoryBlock + (sizeInWords * wordSize))) { return; }
-    
-    // Ensure the address is allocated
-    auto it = allocations.find((uint8_t*)address); // Look for address
-    if (it == allocations.end()) { return; } // Address not found
-    size_t sizeInWords = it->second; // Address found: get the size in words
+    std::vector<size_t> bounds;
+    for (unsigned i = 0; i < threads; i++) { bounds.push_back(((sizeInWords * i) / threads) & ~static_cast<size_t>(7)); }
+    bounds.push_back(sizeInWords);
 
-    allocations.erase(it);
+    return bounds;
+}
 
-    // Determine the offset in bytes (difference between the address and the memory block)
-    size_t offsetInBytes = ((uint8_t *)address - memoryBlock);
+// Index of the first hole starting at or after the word
+static size_t firstHoleFrom(const std::vector<Hole> &holes, size_t word)
+{
+    return std::partition_point(holes.begin(), holes.end(), [word](const Hole &hole) { return hole.offset < word; }) - holes.begin();
+}
 
-    // Convert the offset in bytes to an offset in words
-    size_t offsetInWords = (offsetInBytes / wordSize);
+std::future<void *> MemoryManager::getBitmapParallel(unsigned threads)
+{
+    if (!memoryBlock) { return std::async(std::launch::deferred, []() -> void * { return nullptr; }); }
 
-    // Perform hole updating
-    for (auto it = holes.begin(); it != holes.end(); ++it)
+    std::shared_ptr<std::vector<Hole>> snapshot;
     {
-        // Check if a hole is adjacent to the left of the deallocated memory
-        if ((it->offset + it->size) == offsetInWords)
-        {
-            // Extend the hole to the right
-            it->size += sizeInWords;
-
-            // Check if a hole is adjacent to the right of the deallocated memory (double adjacent)
-            auto itNext = std::next(it);
-            if ((itNext != holes.end()) && (itNext->offset == (offsetInWords + sizeInWords)))
-            {
-                // Extend the first hole further right
-                it->size += (itNext)->size; 
+        SharedLock guard(this);
+        syncHoles();
+        snapshot = std::make_shared<std::vector<Hole>>(holes);
+    }
+    size_t words = sizeInWords;
 
-                // Remove the 2nd hole (left adjacent)
-                holes.erase(itNext);
+    return std::async(std::launch::async, [snapshot, words, threads]() -> void *
+    {
+        // Two size bytes followed by the bitmap
+        size_t bitmapSize = (words + 7) / 8;
+        uint8_t *finalBitmap = new uint8_t[bitmapSize + 2];
+        finalBitmap[0] = bitmapSize & 0xFF;
+        finalBitmap[1] = (bitmapSize >> 8) & 0xFF;
+        uint8_t *bitmap = finalBitmap + 2;
 
-                return;
-            }
+        // Chunks start on byte boundaries, so workers never share a byte; this thread fills the last chunk itself
+        std::vector<size_t> bounds = chunkBounds(words, threads);
+        auto fillChunk = [snapshot, bitmap, &bounds](size_t chunk)
+        {
+            if (bounds[chunk] == bounds[chunk + 1]) { return; }
+            fillBitmapRange(*snapshot, bitmap + (bounds[chunk] / 8), bounds[chunk], bounds[chunk + 1]);
+        };
 
-            return;
-        }
+        std::vector<std::future<void>> workers;
+        for (size_t chunk = 0; chunk + 2 < bounds.size(); chunk++) { workers.push_back(std::async(std::launch::async, fillChunk, chunk)); }
+        fillChunk(bounds.size() - 2);
+        for (auto &worker : workers) { worker.get(); }
 
-        // Check if a hole is only adjacent to the right of the deallocated memory
-        if (it->offset == (offsetInWords + sizeInWords))
-        {
-            // Extend the hole to the left
-            it->offset -= sizeInWords; 
-            it->size += sizeInWords;
-            return;
-        }
-        
-        // Check if the deallocated memory is left of the current hole but not adjacent to any
-        if (offsetInWords < it->offset)
-        {
-            Hole newHole { offsetInWords, sizeInWords };
-            holes.insert(it, newHole);
-            return;
-        }
-    }
+        // Clear the padding bits past the end of memory
+        if (words % 8 != 0) { bitmap[bitmapSize - 1] &= 0xFF >> (8 - (words % 8)); }
 
-    // Deallocated memory is at the very end and non-adjacent to any hole
-    Hole newHole { offsetInWords, sizeInWords };
-    holes.push_back(newHole);
-    return;
+        return finalBitmap;
+    });
 }
 
-void MemoryManager::setAllocator(std::function<int(int, void *)> allocator) { this->allocator = allocator; }
-
-int MemoryManager::dumpMemoryMap(char *filename)
+std::future<int> MemoryManager::dumpMemoryMapParallel(char *filename, unsigned threads)
 {
-    // Open/create the file for writing
-    int openedFile = open(filename, O_TRUNC | O_CREAT | O_WRONLY, 0644);
-    if (openedFile == -1) { return -1; } 
-
-    // Fetch the hole list
-    void *holeList = getList();
+    std::shared_ptr<std::vector<Hole>> snapshot;
+    {
+        SharedLock guard(this);
+        syncHoles();
+        snapshot = std::make_shared<std::vector<Hole>>(holes);
+    }
+    size_t words = sizeInWords;
+    std::string path = filename;
 
-    // Ensure the holeList is valid
-    if (!holeList) 
-    { 
-        close(openedFile);
-        return -1; 
+    // Direct mappings are listed after the holes, as in dumpMemoryMap
+    std::string directText = "";
+    for (auto it = directMappings.begin(); it != directMappings.end(); ++it)
+    {
+        char address[32];
+        snprintf(address, sizeof(address), "%p", static_cast<void *>(it->first));
+        directText += "\ndirect [" + std::string(address) + ", " + std::to_string(it->second.sizeInWords) + "]";
     }
 
-    // Fetch the hole count
-    size_t holeCount = ((uint16_t *)holeList)[0];
-    
-    std::vector<std::string> textVector;
-    for (size_t i = 1; i <= holeCount * 2; i++)
+    return std::async(std::launch::async, [snapshot, words, threads, path, directText]()
     {
-        if (i % 2 != 0)
-        {
-            // i is odd, push offset
-            textVector.push_back("[" + std::to_string(((uint16_t *)holeList)[i]) + ", ");
-        }
-        else
+        // Each worker formats the holes starting in its address range; this thread formats the last range itself
+        std::vector<size_t> bounds = chunkBounds(words, threads);
+        auto formatChunk = [snapshot, &bounds](size_t chunk)
         {
-            // i is even, push size
-            textVector.push_back(std::to_string(((uint16_t *)holeList)[i]) + "]");
+            size_t first = firstHoleFrom(*snapshot, bounds[chunk]);
+            size_t last = (chunk + 2 == bounds.size()) ? snapshot->size() : firstHoleFrom(*snapshot, bounds[chunk + 1]);
 
-            if (i != holeCount * 2)
+            std::string text = "";
+            for (size_t i = first; i < last; i++)
             {
-                // Add " - " if it's not the last element
-                textVector.push_back(" - ");
+                // Add " - " before every hole but the very first
+                if (i != 0) { text += " - "; }
+                text += "[" + std::to_string((*snapshot)[i].offset) + ", " + std::to_string((*snapshot)[i].size) + "]";
             }
-        }
+            return text;
+        };
+
+        std::vector<std::future<std::string>> workers;
+        for (size_t chunk = 0; chunk + 2 < bounds.size(); chunk++) { workers.push_back(std::async(std::launch::async, formatChunk, chunk)); }
+        std::string lastText = formatChunk(bounds.size() - 2);
+
+        // Stitch the pieces together in address order
+        std::string text = "";
+        for (auto &worker : workers) { text += worker.get(); }
+        text += lastText;
+        text += directText;
+
+        // Open/create the file for writing
+        int openedFile = open(path.c_str(), O_TRUNC | O_CREAT | O_WRONLY, 0644);
+        if (openedFile == -1) { return -1; }
+
+        write(openedFile, text.c_str(), text.length());
+        close(openedFile);
+
+        return 0;
+    });
+}
+
+void MemoryManager::setTracing(bool enabled)
+{
+#ifdef MEMORY_MANAGER_TRACE
+    if (enabled && !traceBuffer)
+    {
+        // The ring buffer is only paid for once tracing is first enabled
+        traceBuffer.reset(new TraceEvent[TraceCapacity]);
+        traceEpoch = std::chrono::steady_clock::now();
     }
 
-    delete[] static_cast<uint16_t*>(holeList);
+    tracing.store(enabled, std::memory_order_relaxed);
+#else
+    (void)enabled;
+#endif
+}
 
-    // Write the text vector to the openedFile
-    for (auto text : textVector) { write(openedFile, text.c_str(), text.length());}
+uint64_t MemoryManager::traceNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - traceEpoch).count();
+}
 
-    // Close the file
-    close(openedFile);
+void MemoryManager::recordTrace(TraceOp op, size_t sizeInWords, size_t offsetInWords, uint64_t startTime, size_t holesScanned)
+{
+    // Claim a slot; the oldest events are overwritten once the ring wraps
+    uint64_t index = traceHead.fetch_add(1, std::memory_order_relaxed);
+    TraceEvent &event = traceBuffer[index & (TraceCapacity - 1)];
 
-    // Success
-    return 0;
+    // Mark the slot as being written, fill it, then publish it with its generation
+    event.sequence.store((index * 2) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    event.timestamp = startTime;
+    event.duration = static_cast<uint32_t>(traceNow() - startTime);
+    event.searchDuration = traceSearchNanos;
+    event.updateDuration = traceUpdateNanos;
+    event.size = static_cast<uint32_t>(sizeInWords);
+    event.offset = static_cast<uint32_t>(offsetInWords);
+    event.holesScanned = static_cast<uint32_t>(holesScanned);
+    event.op = op;
+
+    event.sequence.store((index * 2) + 2, std::memory_order_release);
 }
 
-void *MemoryManager::getBitmap()
+int MemoryManager::exportTrace(char *filename)
 {
-    if (!memoryBlock) { return nullptr; }
-    if (sizeInWords == 0) { return nullptr; }
-    
-    // Determine the size (bytes) needed for the bitmap
-    size_t bitmapSize = (sizeInWords / 8);
+    if (!traceBuffer) { return -1; }
 
-    // If there is a remainder, one more byte is required
-    if (sizeInWords % 8 != 0) { bitmapSize++; }
+    // Open/create the file for writing
+    int openedFile = open(filename, O_TRUNC | O_CREAT | O_WRONLY, 0644);
+    if (openedFile == -1) { return -1; }
 
-    // Declare the bitmap
-    uint8_t *bitmap = new uint8_t[bitmapSize];
-    
-    // Initialize the bitmap to 0s (all holes)
-    memset(bitmap, 0, bitmapSize);
-    
-    // Create a buffer bitmap of all 1s
-    uint8_t *bufferBitmap = new uint8_t[bitmapSize]; 
-    memset(bufferBitmap, 0xFF, bitmapSize);
-    
-    // Modify the buffer bitmap with 0s where holes exist
-    // Iterate through each hole
-    for (auto it = holes.begin(); it != holes.end(); ++it) 
+    // Only the most recent TraceCapacity events are still in the ring
+    uint64_t head = traceHead.load(std::memory_order_acquire);
+    uint64_t first = (head > TraceCapacity) ? (head - TraceCapacity) : 0;
+
+    std::string text = "{\"traceEvents\":[";
+    bool firstEvent = true;
+
+    for (uint64_t index = first; index < head; index++)
     {
-        // Iterate through the length (size) of the current hole (it)
-        for (size_t i = 0; i < it->size; ++i) 
+        TraceEvent &event = traceBuffer[index & (TraceCapacity - 1)];
+
+        // Copy the slot, then make sure no writer touched it meanwhile
+        uint64_t sequenceBefore = event.sequence.load(std::memory_order_acquire);
+        TraceOp op = event.op;
+        uint64_t timestamp = event.timestamp;
+        uint32_t duration = event.duration;
+        uint32_t searchDuration = event.searchDuration;
+        uint32_t updateDuration = event.updateDuration;
+        uint32_t size = event.size;
+        uint32_t offset = event.offset;
+        uint32_t holesScanned = event.holesScanned;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t sequenceAfter = event.sequence.load(std::memory_order_relaxed);
+
+        if ((sequenceBefore != sequenceAfter) || (sequenceBefore != (index * 2) + 2)) { continue; }
+
+        // Chrome trace timestamps are in microseconds
+        std::string name = (op == TraceOp::Allocate) ? "allocate" : "free";
+        std::string offsetText = (offset == UINT32_MAX) ? "-1" : std::to_string(offset);
+
+        if (!firstEvent) { text += ","; }
+        firstEvent = false;
+
+        text += "{\"name\":\"" + name + "\",\"ph\":\"X\",\"pid\":1,\"tid\":1";
+        text += ",\"ts\":" + std::to_string(timestamp / 1000.0) + ",\"dur\":" + std::to_string(duration / 1000.0);
+        text += ",\"args\":{\"size\":" + std::to_string(size) + ",\"offset\":" + offsetText;
+        text += ",\"holesScanned\":" + std::to_string(holesScanned) + "}}";
+
+        // Nested slices for the fit search and the hole update
+        if (searchDuration > 0)
         {
-            size_t bitIndex = (it->offset + i);
-            
-            // If bits exist beyond memory, ignore them
-            if (bitIndex >= sizeInWords) { continue; }
-            
-            size_t byteIndex = (bitIndex / 8);
-            size_t bitOffset = (bitIndex % 8);
-            
-            // Set the bit to 0 in the buffer bitmap
-            bufferBitmap[byteIndex] &= ~(1 << bitOffset);
+            text += ",{\"name\":\"fit search\",\"ph\":\"X\",\"pid\":1,\"tid\":1";
+            text += ",\"ts\":" + std::to_string(timestamp / 1000.0) + ",\"dur\":" + std::to_string(searchDuration / 1000.0) + "}";
+        }
+        if (updateDuration > 0)
+        {
+            text += ",{\"name\":\"hole update\",\"ph\":\"X\",\"pid\":1,\"tid\":1";
+            text += ",\"ts\":" + std::to_string((timestamp + searchDuration) / 1000.0) + ",\"dur\":" + std::to_string(updateDuration / 1000.0) + "}";
         }
     }
-    
-    // Now copy the buffer bitmap to the final bitmap
-    memcpy(bitmap, bufferBitmap, bitmapSize);
-    
-    // Ensure the last byte is correct if sizeInWords had a remainder byte
-    if (sizeInWords % 8 != 0) 
-    {
-        size_t lastByteBits = sizeInWords % 8;
-        size_t lastByteIndex = bitmapSize - 1;
-        
-        // Create a mask with 1s for bits to keep
-        uint8_t mask = 0xFF >> (8 - lastByteBits);
-        
-        // Apply the mask to the last byte
-        bitmap[lastByteIndex] &= mask;
-    }
-    
-    delete[] bufferBitmap;
-    
-    // Create the final bitmap with size bytes
-    uint8_t *finalBitmap = new uint8_t[bitmapSize + 2];
-    
-    // Set the first two bytes (size bytes) in little-endian
-    finalBitmap[0] = bitmapSize & 0xFF;
-    finalBitmap[1] = (bitmapSize >> 8) & 0xFF;
-    
-    // Copy the bitmap data to final
-    for (size_t i = 0; i < bitmapSize; i++) { finalBitmap[i + 2] = bitmap[i]; }
 
-    delete[] bitmap;
-    
-    return finalBitmap;
-}
+    text += "]}";
 
-unsigned MemoryManager::getWordSize() { return wordSize; }
+    // Write the trace to the opened file
+    write(openedFile, text.c_str(), text.length());
 
-void *MemoryManager::getMemoryStart() { return memoryBlock; }
+    // Close the file
+    close(openedFile);
 
-unsigned MemoryManager::getMemoryLimit() { return sizeInWords * wordSize; }
+    return 0;
+}
 
 int bestFit(int sizeInWords, void *list)
 {
@@ -331,8 +3109,8 @@ int bestFit(int sizeInWords, void *list)
     size_t holeCount = holeList[0];
 
     // Create variables to keep track of the best fit
-    size_t bestFitOffset = 10000;
-    size_t bestFitSize = 10000;
+    int bestFitOffset = -1;
+    size_t bestFitSize = SIZE_MAX;
 
     // Initialize hole size
     size_t holeSize = 0;
@@ -353,18 +3131,14 @@ int bestFit(int sizeInWords, void *list)
                 bestFitSize = holeSize;
                 bestFitOffset = holeList[i];
             }
+
+            // Nothing beats an exact fit
+            if (holeSize == static_cast<size_t>(sizeInWords)) { break; }
         }
     }
     
-    if (bestFitOffset == 10000)
-    {
-        // No fit found
-        return -1;
-    }
-    else
-    {
-        return bestFitOffset;
-    }
+    // -1 when no fit was found
+    return bestFitOffset;
 }
 
 int worstFit(int sizeInWords, void *list)
@@ -374,7 +3148,7 @@ int worstFit(int sizeInWords, void *list)
     size_t holeCount = holeList[0];
 
     // Create variables to keep track of the best fit
-    size_t worstFitOffset = 10000;
+    int worstFitOffset = -1;
     size_t worstFitSize = 0;
 
     // Initialize hole size
@@ -399,13 +3173,31 @@ int worstFit(int sizeInWords, void *list)
         }
     }
     
-    if (worstFitOffset == 10000)
-    {
-        // No fit found
-        return -1;
-    }
-    else
-    {
-        return worstFitOffset;
-    }
-}
\ No newline at end of file
+    // -1 when no fit was found
+    return worstFitOffset;
+}
+
+void IndexedBestFit::onHolesReset(const std::vector<Hole> &holes)
+{
+    bySize.clear();
+    for (auto it = holes.begin(); it != holes.end(); ++it) { bySize.insert({ it->size, it->offset }); }
+}
+
+void IndexedBestFit::onHoleCreated(const Hole &hole) { bySize.insert({ hole.size, hole.offset }); }
+
+void IndexedBestFit::onHoleResized(const Hole &before, const Hole &after)
+{
+    bySize.erase({ before.size, before.offset });
+    bySize.insert({ after.size, after.offset });
+}
+
+void IndexedBestFit::onHoleRemoved(const Hole &hole) { bySize.erase({ hole.size, hole.offset }); }
+
+long IndexedBestFit::selectHole(size_t sizeInWords)
+{
+    // Smallest hole at least as big as the block, lowest offset among equals
+    auto it = bySize.lower_bound({ sizeInWords, 0 });
+    if (it == bySize.end()) { return -1; }
+
+    return static_cast<long>(it->second);
+}
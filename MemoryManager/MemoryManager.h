@@ -1,8 +1,33 @@
 #pragma once
 #include <functional>
+#include <future>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <cstdint>
+#include <array>
 #include <map>
+#include <set>
+#include <memory>
+#include <string>
+#include <vector>
 #include "Hole.h"
+#include "AllocatorPolicy.h"
+#include "Allocation.h"
+#include "MemoryStats.h"
+#include "HeapSummary.h"
+#include "TraceEvent.h"
+#include "TraceRecord.h"
+
+// Expected lifetime of a block, used to keep short-lived blocks away from long-lived ones
+enum class Lifetime
+{
+    Short, // Placed at the top of the highest hole that fits
+    Medium, // Placed by the allocator as usual
+    Long // Placed at the bottom of the lowest hole that fits
+};
 
 class MemoryManager
 {
@@ -11,23 +36,265 @@ class MemoryManager
     ~MemoryManager();
     void initialize(size_t sizeInWords);
     void shutdown();
+    void reset(bool releasePages = false);
+    void reinitialize(size_t sizeInWords, bool releasePages = false);
     void *getList();
+    size_t getList(uint16_t *buffer, size_t capacity, size_t startWord = 0, size_t rangeInWords = SIZE_MAX);
     void *allocate(size_t sizeInBytes);
+    void *allocate(size_t sizeInBytes, uint8_t tag);
+    void *allocate(size_t sizeInBytes, Lifetime lifetime);
+    void *allocateAligned(size_t sizeInBytes, size_t alignment);
+    void *allocateZeroed(size_t sizeInBytes);
+    void setReleasePagesThreshold(size_t sizeInBytes);
+    void *allocateNear(void *hint, size_t sizeInBytes);
     void free(void *address);
+    void setOwnerThread();
+    void free(void *address, size_t sizeInBytes);
+    bool owns(void *address);
+    void *allocateWait(size_t sizeInBytes, std::chrono::milliseconds timeout);
+    std::future<void *> allocateAsync(size_t sizeInBytes, uint8_t tag = 0);
     void setAllocator(std::function<int(int, void *)> allocator);
+    void setAllocatorPolicy(AllocatorPolicy *policy);
     int dumpMemoryMap(char *filename);
     void *getBitmap();
+    size_t getBitmap(uint8_t *buffer, size_t capacity, size_t startWord = 0, size_t rangeInWords = SIZE_MAX);
     unsigned getWordSize();
     void *getMemoryStart();
     unsigned getMemoryLimit();
+    void setArenaMode(bool enabled);
+    size_t mark();
+    void resetTo(size_t marker);
+    void resetAll();
+    void setTracing(bool enabled);
+    int exportTrace(char *filename);
+    void setBitmapEngine(bool enabled);
+    int initializeShared(const char *name, size_t sizeInWords);
+    int attachShared(const char *name);
+    size_t offsetOf(void *address);
+    void *addressOf(size_t offsetInBytes);
+    size_t getTagBytes(uint8_t tag);
+    void freeAllWithTag(uint8_t tag);
+    void setAdaptive(bool enabled);
+    MemoryStats getStats();
+    HeapSummary getSummary();
+    void setDirectMapThreshold(size_t sizeInBytes);
+    void setBoundaryThreshold(size_t sizeInBytes);
+    size_t addPressureCallback(std::function<void(size_t)> callback, int priority = 0);
+    void removePressureCallback(size_t id);
+    void setUsageLimits(size_t softLimitInBytes, size_t hardLimitInBytes);
+    int startRecording(char *filename);
+    void stopRecording();
+    std::future<void *> getBitmapParallel(unsigned threads);
+    std::future<int> dumpMemoryMapParallel(char *filename, unsigned threads);
 
     private:
+    friend class MemoryManagerResource;
+    class SharedLock;
+
+    void discardQueued();
+    void *bumpAllocate(size_t sizeInWords);
+    void recordBlock(uint8_t *address, size_t sizeInWords, uint8_t tag = 0);
+    size_t forgetBlock(uint8_t *address);
+    void setBlockStart(size_t offsetInWords, bool started);
+    bool isBlockStart(size_t offsetInWords);
+    void releaseBlock(size_t offsetInWords, size_t sizeInWords);
+    void servePending(size_t offsetInWords);
+    void wakeWaiters();
+    void holeCreated(const Hole &hole);
+    void holeResized(const Hole &before, const Hole &after);
+    void holeRemoved(const Hole &hole);
+    void holesReset();
+    void publishSummary();
+    size_t usedBytes();
+    bool enforceUsageLimits(size_t requestBytes);
+    void relievePressure(size_t shortfallInBytes, std::function<bool()> relieved);
+    bool relieveShortfall(size_t sizeInWords);
+    int mapShared(const char *name, bool create, size_t sizeInWords);
+    uint32_t *sharedBlockSizes();
+    bool sharedHolesValid();
+    void rebuildSharedHoles();
+    size_t adaptiveScanCount(size_t sizeInWords);
+    void adaptiveRecord(size_t sizeInWords, bool succeeded, size_t holesScanned);
+    double currentFragmentation();
+    void *allocateDirect(size_t sizeInBytes, uint8_t tag);
+    bool freeDirect(void *address);
+    size_t directMappedBytes(size_t sizeInWords);
+    void recordOp(RecordOp op, size_t sizeInWords, size_t offsetInWords);
+    void writeRecord(RecordOp op, uint64_t delta, size_t sizeInWords, size_t offsetInWords);
+    void recordLiveBlocks();
+    void flushRecording();
+    size_t toWords(size_t sizeInBytes);
+    size_t naturalAlignment();
+    void *allocateBlock(size_t sizeInBytes, uint8_t tag, Lifetime lifetime);
+    void *placeBlock(size_t sizeInWords, Lifetime lifetime = Lifetime::Medium);
+    void *placeAligned(size_t sizeInWords, size_t alignment);
+    void *placeNear(size_t sizeInWords, size_t hintInWords);
+    size_t avoidBoundaries(size_t offsetInWords, size_t sizeInWords);
+    void countStraddles(uint8_t *address, size_t sizeInWords, bool added);
+    bool carveRange(size_t offsetInWords, size_t sizeInWords);
+    size_t releaseRange(size_t offsetInWords, size_t sizeInWords);
+    void *allocateUntracked(size_t sizeInBytes, size_t alignment);
+    void releaseUntracked(void *address, size_t sizeInBytes);
+    void freeLocal(void *address);
+    void releaseUntrackedLocal(void *address, size_t sizeInBytes);
+    bool isRemoteThread();
+    void pushRemoteFree(void *address, size_t sizeInBytes);
+    void drainRemoteFrees();
+    void markWords(size_t offsetInWords, size_t sizeInWords, bool used);
+    void markDirty(size_t offsetInWords, size_t sizeInWords);
+    bool wordsFree(size_t offsetInWords, size_t sizeInWords);
+    long findFreeRun(size_t sizeInWords);
+    size_t freeWordsBefore(size_t offsetInWords);
+    size_t freeWordsAfter(size_t offsetInWords);
+    size_t largestFreeRun();
+    void syncHoles();
+    uint64_t traceNow();
+    void recordTrace(TraceOp op, size_t sizeInWords, size_t offsetInWords, uint64_t startTime, size_t holesScanned);
+
     unsigned wordSize = 0;
     size_t sizeInWords = 0;
+    size_t capacityInWords = 0; // Size the memory block was mapped with; reinitialize may use less of it
     std::function<int(int, void *)> allocator = nullptr;
+    AllocatorPolicy *policy = nullptr; // Not owned; replaces allocator when set
     uint8_t* memoryBlock = nullptr;
     std::vector<Hole> holes = {};
-    std::map<uint8_t*, size_t> allocations = {};
+    std::vector<uint32_t> blockSizes = {}; // Per word: size of the tracked block starting there, 0 elsewhere
+    std::vector<uint8_t> blockTags = {}; // Per word: tag of the tracked block starting there
+    size_t liveBlocks = 0;
+    std::array<size_t, 256> tagBytes = {}; // Live bytes per allocation tag
+    std::vector<uint64_t> blockStarts = {}; // One bit per word, set where a live block (tracked or untracked) begins
+
+    // Arena (bump-pointer) mode: blocks live in [arenaBase, arenaTop) and are not tracked in the block tables
+    bool arenaMode = false;
+    size_t arenaBase = 0;
+    size_t arenaTop = 0;
+
+    // Frees from threads other than the owner are queued (lock-free, many producers) and drained by the owner.
+    // The first thread to allocate becomes the owner unless setOwnerThread picks one; until then frees are local.
+    struct RemoteFree
+    {
+        void *address = nullptr;
+        size_t sizeInBytes = 0; // 0 when the size must come from the block tables
+        RemoteFree *next = nullptr;
+    };
+    std::atomic<std::thread::id> ownerThread = { std::thread::id() };
+    std::atomic<RemoteFree*> remoteFrees = { nullptr };
+
+    // Blocking waiters sleep until a remote free is queued or a release makes room for them; the condition is only
+    // signalled while someone waits
+    std::mutex waitMutex;
+    std::condition_variable freeSignal;
+    std::atomic<size_t> waiters = { 0 };
+    std::multiset<size_t> waitingWords = {}; // Sizes the waiters need, guarded by waitMutex
+
+    // Async requests that did not fit yet, largest first; retried when a free coalesces a big enough hole
+    struct PendingAllocation
+    {
+        size_t sizeInBytes = 0;
+        uint8_t tag = 0;
+        std::promise<void *> promise;
+    };
+    std::multimap<size_t, PendingAllocation, std::greater<size_t>> pendingAllocations = {}; // Keyed by size in words
+    bool servingPending = false;
+
+    // Event tracing (recorded only when built with MEMORY_MANAGER_TRACE)
+    static const size_t TraceCapacity = 16384; // Power of two
+    std::atomic<bool> tracing = { false };
+    std::unique_ptr<TraceEvent[]> traceBuffer = nullptr;
+    std::atomic<uint64_t> traceHead = { 0 };
+    std::chrono::steady_clock::time_point traceEpoch = {};
+    uint32_t traceSearchNanos = 0; // Filled by placeBlock for the event being recorded
+    uint32_t traceUpdateNanos = 0;
+
+    // Free words known to still read as zero (1 = zero): fresh mmap pages and pages released with MADV_DONTNEED.
+    // Only meaningful for free words; a block's bits are cleared when it is released. Empty for shared heaps.
+    size_t releasePagesThreshold = 0; // Frees at least this big hand their whole pages back (0 = never, the default)
+    static const size_t StreamZeroBytes = 64 * 1024; // Dirty ranges at least this big are cleared with streaming stores
+    std::vector<uint64_t> zeroBits = {};
+
+    // allocateNear looks at no more than this many holes on each side of the hint
+    static const size_t NearSearchHoles = 32;
+
+    // Bitmap engine: one bit per word (1 = used) is authoritative and holes is rebuilt from it on demand.
+    // Blocks are placed first fit by scanning 64 words at a time; the allocator function is not consulted.
+    bool bitmapEngine = false;
+    std::vector<uint64_t> usedBits = {};
+    std::vector<uint64_t> fullBits = {}; // One bit per usedBits entry, set when all 64 words are used
+    bool holesDirty = false;
+
+    // Shared-memory heap: header, holes, block sizes and the memory block all live in one shm segment.
+    // holes is a local copy kept under the segment's process-shared lock; a generation counter in the segment
+    // tells each process when another one has changed the holes, so unchanged holes are never reloaded.
+    struct SharedHeader *sharedHeader = nullptr;
+    size_t sharedBytes = 0;
+    std::string sharedName = "";
+    bool sharedCreator = false;
+    size_t sharedDepth = 0; // Nesting of SharedLock on the thread holding the lock
+    uint64_t sharedGeneration = 0; // Segment generation the local holes were last loaded from or stored as
+
+    // Hole summary kept up to date by the hole hooks and published under a seqlock at the end of each operation,
+    // so other threads can read it without locking. The bitmap engine only refreshes it when it rebuilds the holes.
+    size_t summaryFreeWords = 0;
+    size_t summaryHoleCount = 0;
+    size_t summaryLargestHole = 0;
+    bool summaryLargestStale = false; // The largest hole shrank or went away: rescan before publishing
+    bool summaryDirty = false;
+    alignas(64) std::atomic<uint64_t> summarySequence = { 0 }; // Odd while a write is in progress
+    std::atomic<size_t> publishedFreeWords = { 0 };
+    std::atomic<size_t> publishedLargestHole = { 0 };
+    std::atomic<size_t> publishedHoleCount = { 0 };
+
+    // Adaptive strategy selection: the committed policy runs for windows of allocations,
+    // and every few windows the other policy is tried for one window and kept if it scores clearly better.
+    // Off while the bitmap engine places blocks.
+    static const size_t AdaptiveWindow = 256;
+    static const size_t AdaptiveExploreEvery = 8;
+    bool adaptive = false;
+    std::function<int(int, void *)> savedAllocator = nullptr; // Caller's choice, restored when adaptive selection is turned off
+    AllocatorPolicy *savedPolicy = nullptr;
+    size_t adaptiveHome = 0; // Committed policy (index into the built-in policies)
+    size_t adaptiveActive = 0; // Policy running this window
+    bool adaptiveExploring = false;
+    double adaptiveScores[2] = { 0, 0 };
+    bool adaptiveScored[2] = { false, false };
+    size_t adaptiveOps = 0;
+    size_t adaptiveFailures = 0;
+    size_t adaptiveScanned = 0;
+    size_t adaptiveWindows = 0;
+    size_t adaptiveWindowsSinceExplore = 0;
+    size_t adaptiveSwitches = 0;
+
+    // Blocks of at most boundaryThreshold bytes are shifted inside their hole so they do not cross
+    // a cache line (if they fit in one) or a page. Live small blocks that do cross are counted.
+    // Off (0) by default: the skipped words only come back when smaller blocks fill them, so a heap of one
+    // object size that does not divide the line (48 bytes, say) fits fewer objects and gains nothing.
+    static const size_t CacheLineBytes = 64;
+    static const size_t PageBytes = 4096;
+    size_t boundaryThreshold = 0;
+    size_t lineStraddlers = 0;
+    size_t pageStraddlers = 0;
+
+    // Pressure callbacks are asked to free memory (given the shortfall in bytes) before an allocation fails
+    // or pushes usage of the memory block past a limit; lower priority values are asked first
+    struct PressureCallback
+    {
+        size_t id = 0;
+        int priority = 0;
+        std::function<void(size_t)> callback = nullptr;
+    };
+    std::vector<PressureCallback> pressureCallbacks = {}; // Sorted by priority
+    size_t nextPressureId = 1;
+    bool relievingPressure = false; // Callbacks that allocate must not trigger another round
+    size_t softLimit = 0; // Crossing it asks for memory back but still allocates (0 = none)
+    size_t hardLimit = 0; // Crossing it asks for memory back, then fails if still over (0 = none)
+
+    // Requests of at least directMapThreshold bytes get their own mmap region outside the memory block (0 = off)
+    size_t directMapThreshold = 0;
+    std::map<uint8_t*, Allocation> directMappings = {};
+    size_t directBytes = 0; // Mapped bytes of all direct mappings
+
+    // Binary trace recorder (buffers and background writer thread), null when not recording
+    struct Recorder *recorder = nullptr;
 };
 
 int bestFit(int sizeInWords, void *list);
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include "MemoryManager.h"
+
+// Lets std::pmr containers draw their storage from a MemoryManager heap.
+// Node-sized requests (up to SmallBytes) are cached on per-size free lists when deallocated and handed straight
+// back on the next request of that size class, so container churn skips the hole search. Cached blocks stay
+// allocated in the heap until the resource is destroyed or the manager runs short and calls the resource's
+// pressure callback. Like std::pmr::unsynchronized_pool_resource, the cache is not thread safe, and the
+// resource must be destroyed before the manager is re-initialized.
+class MemoryManagerResource : public std::pmr::memory_resource
+{
+    public:
+    explicit MemoryManagerResource(MemoryManager &manager) : manager(manager)
+    {
+        // Cached blocks are all placed at the heap's natural alignment so any block of a class fits any request
+        size_t wordSize = manager.getWordSize();
+        smallAlignment = wordSize & (~wordSize + 1);
+        if (smallAlignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) { smallAlignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__; }
+
+        pressureId = manager.addPressureCallback([this](size_t) { releaseCached(); });
+    }
+
+    ~MemoryManagerResource()
+    {
+        manager.removePressureCallback(pressureId);
+        releaseCached();
+    }
+
+    MemoryManagerResource(const MemoryManagerResource &) = delete;
+    MemoryManagerResource &operator=(const MemoryManagerResource &) = delete;
+
+    MemoryManager &getManager() { return manager; }
+
+    // Give every cached block back to the manager
+    void releaseCached()
+    {
+        for (size_t i = 0; i < SmallClasses; i++)
+        {
+            while (freeBlocks[i])
+            {
+                FreeBlock *block = freeBlocks[i];
+                freeBlocks[i] = block->next;
+                manager.releaseUntracked(block, classBytes(i));
+            }
+        }
+    }
+
+    private:
+    static const size_t ClassBytes = 16;
+    static const size_t SmallBytes = 256;
+    static const size_t SmallClasses = SmallBytes / ClassBytes;
+
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+
+    static size_t classOf(size_t bytes) { return (bytes - 1) / ClassBytes; }
+    static size_t classBytes(size_t sizeClass) { return (sizeClass + 1) * ClassBytes; }
+
+    bool isSmall(size_t bytes, size_t alignment) const { return (bytes <= SmallBytes) && (alignment <= smallAlignment); }
+
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        // Zero-byte requests still need a unique address
+        if (bytes == 0) { bytes = 1; }
+
+        if (isSmall(bytes, alignment))
+        {
+            // Reuse a cached block of the same class, or place a new one of the full class size
+            size_t sizeClass = classOf(bytes);
+            if (FreeBlock *block = freeBlocks[sizeClass])
+            {
+                freeBlocks[sizeClass] = block->next;
+                return block;
+            }
+
+            bytes = classBytes(sizeClass);
+            alignment = smallAlignment;
+        }
+
+        void *address = manager.allocateUntracked(bytes, alignment);
+        if (!address) { throw std::bad_alloc(); }
+
+        return address;
+    }
+
+    void do_deallocate(void *address, size_t bytes, size_t alignment) override
+    {
+        if (bytes == 0) { bytes = 1; }
+
+        // Small blocks go on their class's free list
+        if (isSmall(bytes, alignment))
+        {
+            size_t sizeClass = classOf(bytes);
+            FreeBlock *block = static_cast<FreeBlock *>(address);
+            block->next = freeBlocks[sizeClass];
+            freeBlocks[sizeClass] = block;
+            return;
+        }
+
+        // Sized deallocation: the container knows the size, so the block tables are indexed directly
+        manager.releaseUntracked(address, bytes);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+    MemoryManager &manager;
+    size_t smallAlignment = 1;
+    size_t pressureId = 0;
+    FreeBlock *freeBlocks[SmallClasses] = {};
+};
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+
+// Snapshot returned by MemoryManager::getStats
+struct MemoryStats
+{
+    size_t freeWords = 0;
+    size_t largestHole = 0; // In words
+    size_t holeCount = 0;
+    size_t allocationCount = 0;
+
+    // Live blocks that fit in a cache line (page) but cross one (see MemoryManager::setBoundaryThreshold); not kept for shared heaps
+    size_t lineStraddlingBlocks = 0;
+    size_t pageStraddlingBlocks = 0;
+
+    // Large blocks mapped outside the memory block (see MemoryManager::setDirectMapThreshold)
+    size_t directMappedCount = 0;
+    size_t directMappedBytes = 0;
+
+    // Adaptive strategy selection (see MemoryManager::setAdaptive)
+    bool adaptive = false;
+    const char *adaptivePolicy = ""; // Policy currently committed to
+    size_t adaptiveSwitches = 0;
+    size_t adaptiveWindows = 0;
+    double bestFitScore = 0; // Lower is better: fragmentation plus failure and search cost
+    double worstFitScore = 0;
+};
@@ -0,0 +1,154 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include "MemoryManager.h"
+
+// Pool of same-type objects carved from large chunks of a MemoryManager heap.
+// Each chunk is one aligned allocateAligned call; free slots are threaded through an intrusive list
+// per chunk, so create/destroy never search holes or touch the block tables. Empty chunks go back
+// to the manager. Objects still alive when the pool is destroyed are not destructed.
+template <typename T>
+class ObjectPool
+{
+    public:
+    ObjectPool(MemoryManager &manager, size_t chunkSizeInBytes = 4096) : manager(manager)
+    {
+        // Chunks are power-of-two sized and aligned so a slot finds its chunk with a mask
+        chunkSize = 64;
+        while (chunkSize < chunkSizeInBytes || chunkSize < headerSize() + slotSize()) { chunkSize *= 2; }
+        slotsPerChunk = (chunkSize - headerSize()) / slotSize();
+    }
+
+    ~ObjectPool()
+    {
+        // Return every chunk, empty or not
+        while (partialChunks) { releaseChunk(partialChunks); }
+        while (fullChunks) { releaseChunk(fullChunks); }
+    }
+
+    ObjectPool(const ObjectPool &) = delete;
+    ObjectPool &operator=(const ObjectPool &) = delete;
+
+    template <typename... Args>
+    T *create(Args &&...args)
+    {
+        // Take a slot from the first chunk that has one, grabbing a new chunk if none do
+        if (!partialChunks && !grabChunk()) { return nullptr; }
+
+        Chunk *chunk = partialChunks;
+        Slot *slot = chunk->freeSlots;
+        chunk->freeSlots = slot->next;
+        chunk->liveCount++;
+
+        // A chunk with no free slots leaves the partial list
+        if (!chunk->freeSlots) { moveChunk(chunk, partialChunks, fullChunks); }
+
+        return new (slot) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T *object)
+    {
+        if (!object) { return; }
+        object->~T();
+
+        Chunk *chunk = chunkOf(object);
+        Slot *slot = reinterpret_cast<Slot *>(object);
+
+        // A full chunk gains a free slot and rejoins the partial list
+        if (!chunk->freeSlots) { moveChunk(chunk, fullChunks, partialChunks); }
+
+        slot->next = chunk->freeSlots;
+        chunk->freeSlots = slot;
+        chunk->liveCount--;
+
+        // Hand empty chunks back, keeping one around to avoid thrashing at the boundary
+        if ((chunk->liveCount == 0) && ((chunk != partialChunks) || chunk->next)) { releaseChunk(chunk); }
+    }
+
+    size_t getSlotsPerChunk() { return slotsPerChunk; }
+
+    private:
+    struct Slot
+    {
+        Slot *next;
+    };
+
+    struct Chunk
+    {
+        Chunk *previous;
+        Chunk *next;
+        Slot *freeSlots;
+        size_t liveCount;
+    };
+
+    static size_t slotAlignment() { return alignof(T) > alignof(Slot) ? alignof(T) : alignof(Slot); }
+
+    static size_t slotSize()
+    {
+        // Big enough for a T or a free-list link, rounded to the slot alignment
+        size_t size = sizeof(T) > sizeof(Slot) ? sizeof(T) : sizeof(Slot);
+        return (size + slotAlignment() - 1) & ~(slotAlignment() - 1);
+    }
+
+    static size_t headerSize() { return (sizeof(Chunk) + slotAlignment() - 1) & ~(slotAlignment() - 1); }
+
+    Chunk *chunkOf(T *object) { return reinterpret_cast<Chunk *>(reinterpret_cast<uintptr_t>(object) & ~(static_cast<uintptr_t>(chunkSize) - 1)); }
+
+    bool grabChunk()
+    {
+        uint8_t *memory = static_cast<uint8_t *>(manager.allocateAligned(chunkSize, chunkSize));
+        if (!memory) { return false; }
+
+        Chunk *chunk = reinterpret_cast<Chunk *>(memory);
+        chunk->previous = nullptr;
+        chunk->next = nullptr;
+        chunk->freeSlots = nullptr;
+        chunk->liveCount = 0;
+
+        // Thread the free list through the slots, lowest address first
+        for (size_t i = slotsPerChunk; i > 0; i--)
+        {
+            Slot *slot = reinterpret_cast<Slot *>(memory + headerSize() + ((i - 1) * slotSize()));
+            slot->next = chunk->freeSlots;
+            chunk->freeSlots = slot;
+        }
+
+        pushChunk(chunk, partialChunks);
+        return true;
+    }
+
+    void releaseChunk(Chunk *chunk)
+    {
+        unlinkChunk(chunk, chunk->freeSlots ? partialChunks : fullChunks);
+        manager.free(chunk);
+    }
+
+    void pushChunk(Chunk *chunk, Chunk *&list)
+    {
+        chunk->previous = nullptr;
+        chunk->next = list;
+        if (list) { list->previous = chunk; }
+        list = chunk;
+    }
+
+    void unlinkChunk(Chunk *chunk, Chunk *&list)
+    {
+        if (chunk->previous) { chunk->previous->next = chunk->next; }
+        else { list = chunk->next; }
+        if (chunk->next) { chunk->next->previous = chunk->previous; }
+    }
+
+    void moveChunk(Chunk *chunk, Chunk *&from, Chunk *&to)
+    {
+        unlinkChunk(chunk, from);
+        pushChunk(chunk, to);
+    }
+
+    MemoryManager &manager;
+    size_t chunkSize = 0;
+    size_t slotsPerChunk = 0;
+    Chunk *partialChunks = nullptr; // Chunks with at least one free slot
+    Chunk *fullChunks = nullptr;
+};
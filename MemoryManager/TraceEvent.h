@@ -0,0 +1,23 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+enum class TraceOp : uint8_t
+{
+    Allocate = 0,
+    Free = 1
+};
+
+// One slot of the tracing ring buffer
+struct TraceEvent
+{
+    std::atomic<uint64_t> sequence = { 0 }; // Odd while the slot is being written, even once published
+    uint64_t timestamp = 0; // Nanoseconds since tracing was enabled
+    uint32_t duration = 0; // Whole operation in nanoseconds
+    uint32_t searchDuration = 0; // Time spent in the allocator (fit search)
+    uint32_t updateDuration = 0; // Time spent updating the holes
+    uint32_t size = 0; // In words
+    uint32_t offset = 0; // In words, UINT32_MAX when the allocation failed
+    uint32_t holesScanned = 0;
+    TraceOp op = TraceOp::Allocate;
+};
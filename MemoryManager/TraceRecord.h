@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+
+// Binary allocation trace written by MemoryManager::startRecording.
+// Header: the magic bytes, a version byte, then the word size and size in words as varints.
+// Each record: an op byte, then varints for the nanoseconds since the previous record,
+// the size in words and (except for failed allocations) the offset in words.
+// Blocks already live when recording starts open the trace as Allocate records with a delta of 0.
+// Varints are little-endian base 128: 7 bits per byte, high bit set on all but the last byte.
+const char TraceRecordMagic[4] = { 'M', 'M', 'T', 'R' };
+const uint8_t TraceRecordVersion = 1;
+
+enum class RecordOp : uint8_t
+{
+    Allocate = 0,
+    Free = 1,
+    FailedAllocate = 2
+};
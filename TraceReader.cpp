@@ -0,0 +1,161 @@
+#include "MemoryManager/TraceRecord.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <vector>
+
+
+
+// Decodes a trace written by MemoryManager::startRecording and checks it is a consistent allocation history:
+// every block lies inside the heap, no two live blocks overlap, and every free matches a live block.
+// Usage: TraceReader <trace file> [-v]
+
+
+// helper functions
+bool readVarint(const std::vector<uint8_t>& data, size_t& position, uint64_t& value);
+bool overlapsLiveBlock(const std::map<uint64_t, uint64_t>& liveBlocks, uint64_t offset, uint64_t size);
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: " << argv[0] << " <trace file> [-v]" << std::endl;
+        return 2;
+    }
+    bool verbose = (argc > 2) && (strcmp(argv[2], "-v") == 0);
+
+    // Read the whole trace
+    std::ifstream traceFile(argv[1], std::ios::binary);
+    if (!traceFile.is_open())
+    {
+        std::cout << "Could not open " << argv[1] << std::endl;
+        return 2;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(traceFile)), std::istreambuf_iterator<char>());
+
+    // Header: magic, version, word size, size in words
+    size_t position = 0;
+    uint64_t wordSize = 0;
+    uint64_t sizeInWords = 0;
+    if ((data.size() < sizeof(TraceRecordMagic) + 1) || (memcmp(data.data(), TraceRecordMagic, sizeof(TraceRecordMagic)) != 0))
+    {
+        std::cout << "[INVALID] not a MemoryManager trace" << std::endl;
+        return 1;
+    }
+    position += sizeof(TraceRecordMagic);
+    if (data[position++] != TraceRecordVersion)
+    {
+        std::cout << "[INVALID] unsupported trace version" << std::endl;
+        return 1;
+    }
+    if (!readVarint(data, position, wordSize) || !readVarint(data, position, sizeInWords))
+    {
+        std::cout << "[INVALID] truncated header" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Word size: " << wordSize << ", heap: " << sizeInWords << " words" << std::endl;
+
+    // Replay the records against a map of live blocks (offset -> size)
+    std::map<uint64_t, uint64_t> liveBlocks;
+    uint64_t allocateCount = 0;
+    uint64_t freeCount = 0;
+    uint64_t failedCount = 0;
+    uint64_t elapsed = 0;
+    uint64_t recordIndex = 0;
+
+    while (position < data.size())
+    {
+        uint8_t op = data[position++];
+        uint64_t delta = 0;
+        uint64_t size = 0;
+        uint64_t offset = 0;
+
+        bool complete = readVarint(data, position, delta) && readVarint(data, position, size);
+        if (complete && (op != static_cast<uint8_t>(RecordOp::FailedAllocate))) { complete = readVarint(data, position, offset); }
+        if (!complete)
+        {
+            std::cout << "[INVALID] record " << recordIndex << " is truncated" << std::endl;
+            return 1;
+        }
+
+        elapsed += delta;
+
+        if (verbose)
+        {
+            std::cout << elapsed << " ns: op " << (int)op << " size " << size << " offset " << offset << std::endl;
+        }
+
+        if (op == static_cast<uint8_t>(RecordOp::Allocate))
+        {
+            if ((size == 0) || (offset + size > sizeInWords) || overlapsLiveBlock(liveBlocks, offset, size))
+            {
+                std::cout << "[INVALID] record " << recordIndex << ": allocation [" << offset << ", " << size << "] is out of bounds or overlaps a live block" << std::endl;
+                return 1;
+            }
+            liveBlocks[offset] = size;
+            allocateCount++;
+        }
+        else if (op == static_cast<uint8_t>(RecordOp::Free))
+        {
+            auto it = liveBlocks.find(offset);
+            if ((it == liveBlocks.end()) || (it->second != size))
+            {
+                std::cout << "[INVALID] record " << recordIndex << ": free [" << offset << ", " << size << "] does not match a live block" << std::endl;
+                return 1;
+            }
+            liveBlocks.erase(it);
+            freeCount++;
+        }
+        else if (op == static_cast<uint8_t>(RecordOp::FailedAllocate))
+        {
+            failedCount++;
+        }
+        else
+        {
+            std::cout << "[INVALID] record " << recordIndex << " has unknown op " << (int)op << std::endl;
+            return 1;
+        }
+
+        recordIndex++;
+    }
+
+    std::cout << "Records: " << recordIndex << " (" << allocateCount << " allocate, " << freeCount << " free, " << failedCount << " failed)" << std::endl;
+    std::cout << "Duration: " << elapsed << " ns" << std::endl;
+    std::cout << "Blocks live at end: " << liveBlocks.size() << std::endl;
+    std::cout << "[VALID]" << std::endl;
+
+    return 0;
+}
+
+
+bool readVarint(const std::vector<uint8_t>& data, size_t& position, uint64_t& value)
+{
+    value = 0;
+
+    for (unsigned int shift = 0; shift < 64; shift += 7)
+    {
+        if (position >= data.size()) { return false; }
+
+        uint8_t byte = data[position++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) { return true; }
+    }
+
+    // Too many continuation bytes
+    return false;
+}
+
+
+bool overlapsLiveBlock(const std::map<uint64_t, uint64_t>& liveBlocks, uint64_t offset, uint64_t size)
+{
+    // The first block starting after the offset, and the one before it
+    auto next = liveBlocks.upper_bound(offset);
+    if ((next != liveBlocks.end()) && (next->first < offset + size)) { return true; }
+    if (next == liveBlocks.begin()) { return false; }
+
+    auto previous = std::prev(next);
+    return (previous->first + previous->second) > offset;
+}